@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../containers/hash_table.hpp"
+#include "../containers/partitioned_hash_table.hpp"
+#include "parallel_for.hpp"
+
+namespace lmj {
+namespace detail {
+struct add_assign {
+    template<class T, class G>
+    constexpr void operator()(T &a, G &&b) const { a += std::forward<G>(b); }
+};
+} // namespace detail
+
+/**
+ * @brief groups the elements of range by key and folds every group into an accumulator using all threads,
+ * every thread aggregates its slice of range into its own table per partition of the key hashes,
+ * then every partition is merged by a single thread so no state is shared at any point
+ * @param key_fn maps an element to its key
+ * @param acc_fn called as acc_fn(acc_type &, element) to fold an element into the accumulator of its group
+ * @param threads number of threads to use
+ * @param combine called as combine(acc_type &, acc_type &&) to merge partial accumulators of the same group
+ * @return table of accumulators by key, split into at least threads partitions
+ */
+template<class acc_type, std::ranges::random_access_range range_type, class key_fn_type, class acc_fn_type,
+         class combine_type = detail::add_assign,
+         class key_type = std::remove_cvref_t<std::invoke_result_t<key_fn_type &, std::ranges::range_reference_t<range_type const>>>,
+         class hash_type = std::hash<key_type>>
+auto aggregate(range_type const &range, key_fn_type key_fn, acc_fn_type acc_fn,
+               std::size_t threads = default_thread_count(), combine_type combine = {}) {
+    using result_type = partitioned_hash_table<key_type, acc_type, hash_type>;
+    using table_type = typename result_type::table_type;
+    threads = std::max<std::size_t>(threads, 1);
+    result_type result{detail::partition_bits_for(threads)};
+    const std::size_t partitions = result.partition_count();
+    const auto n = static_cast<std::size_t>(std::ranges::size(range));
+    const auto first = std::ranges::begin(range);
+
+    // local[t * partitions + p] holds what thread t saw of partition p
+    std::vector<table_type> local(threads * partitions);
+    parallel_for(threads, [&](std::size_t t) {
+        const std::size_t lo = n * t / threads, hi = n * (t + 1) / threads;
+        table_type *tables = local.data() + t * partitions;
+        for (std::size_t i = lo; i < hi; ++i) {
+            auto &&elem = first[static_cast<std::iter_difference_t<decltype(first)>>(i)];
+            key_type key = key_fn(elem);
+            acc_fn(tables[result.partition_index(key)][key], elem);
+        }
+    });
+
+    parallel_for(std::min(threads, partitions), [&](std::size_t t) {
+        for (std::size_t p = t; p < partitions; p += threads) {
+            // start from the largest partial table so the fewest keys are reinserted
+            std::size_t largest = 0;
+            for (std::size_t i = 1; i < threads; ++i)
+                if (local[i * partitions + p].size() > local[largest * partitions + p].size())
+                    largest = i;
+            table_type &dest = result.partition(p);
+            dest = std::move(local[largest * partitions + p]);
+            for (std::size_t i = 0; i < threads; ++i) {
+                if (i == largest)
+                    continue;
+                for (auto &[key, acc]: local[i * partitions + p]) {
+                    if (auto it = dest.find(key); it != dest.end())
+                        combine(it->second, std::move(acc));
+                    else
+                        dest.emplace(key, std::move(acc));
+                }
+                local[i * partitions + p] = {};
+            }
+        }
+    });
+    return result;
+}
+} // namespace lmj
@@ -0,0 +1,5 @@
+#pragma once
+
+#include "aggregate.hpp"
+#include "hash_join.hpp"
+#include "parallel_for.hpp"
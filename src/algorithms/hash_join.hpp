@@ -0,0 +1,178 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../containers/hash_table.hpp"
+#include "../containers/partitioned_hash_table.hpp"
+#include "parallel_for.hpp"
+
+namespace lmj {
+namespace detail {
+template<class key_type>
+struct join_entry {
+    key_type key{};
+    std::size_t index{};
+};
+
+template<class key_type>
+struct radix_partitions {
+    std::vector<join_entry<key_type>> entries;
+    std::vector<std::size_t> offsets; // partition p is entries[offsets[p], offsets[p + 1])
+};
+
+/**
+ * @brief scatters the keys of range into 2^bits partitions by hash, in parallel and preserving order within partitions
+ */
+template<class key_type, class range_type, class key_fn_type, class hash_type>
+radix_partitions<key_type> radix_partition(range_type const &range, key_fn_type &key_fn, hash_type const &hasher,
+                                           unsigned bits, std::size_t threads) {
+    const std::size_t partitions = std::size_t{1} << bits;
+    const auto n = static_cast<std::size_t>(std::ranges::size(range));
+    const auto first = std::ranges::begin(range);
+    using difference_type = std::iter_difference_t<decltype(first)>;
+    auto partition_of_elem = [&](std::size_t i) {
+        return partition_of(static_cast<std::uint64_t>(hasher(key_fn(first[static_cast<difference_type>(i)]))), bits);
+    };
+
+    // cursors[t * partitions + p] is where thread t writes its next entry of partition p
+    std::vector<std::size_t> cursors(threads * partitions);
+    parallel_for(threads, [&](std::size_t t) {
+        for (std::size_t i = n * t / threads; i < n * (t + 1) / threads; ++i)
+            ++cursors[t * partitions + partition_of_elem(i)];
+    });
+    radix_partitions<key_type> result{std::vector<join_entry<key_type>>(n), std::vector<std::size_t>(partitions + 1)};
+    std::size_t sum = 0;
+    for (std::size_t p = 0; p < partitions; ++p) {
+        result.offsets[p] = sum;
+        for (std::size_t t = 0; t < threads; ++t)
+            sum += std::exchange(cursors[t * partitions + p], sum);
+    }
+    result.offsets[partitions] = sum;
+    parallel_for(threads, [&](std::size_t t) {
+        for (std::size_t i = n * t / threads; i < n * (t + 1) / threads; ++i) {
+            auto &&elem = first[static_cast<difference_type>(i)];
+            key_type key = key_fn(elem);
+            const std::size_t p = partition_of(static_cast<std::uint64_t>(hasher(key)), bits);
+            result.entries[cursors[t * partitions + p]++] = {std::move(key), i};
+        }
+    });
+    return result;
+}
+
+/**
+ * @return number of partition bits so a partition of the build side fits in partition_bytes,
+ * with at least as many partitions as threads
+ */
+template<class key_type>
+constexpr unsigned join_partition_bits(std::size_t build_size, std::size_t threads, std::size_t partition_bytes) {
+    // entry, chain link and a hash table slot at half load
+    constexpr std::size_t bytes_per_row = sizeof(join_entry<key_type>) + sizeof(std::size_t) +
+                                          2 * (sizeof(std::pair<const key_type, std::size_t>) + 1);
+    constexpr unsigned max_bits = 12; // beyond this one pass of scattering thrashes the tlb
+    unsigned bits = partition_bits_for(threads);
+    while (bits < max_bits && (build_size >> bits) * bytes_per_row > partition_bytes)
+        ++bits;
+    return bits;
+}
+
+template<class key_type, class hash_type, class build_range_type, class probe_range_type,
+         class build_key_fn_type, class probe_key_fn_type, class match_fn_type>
+void hash_join_impl(build_range_type const &build, probe_range_type const &probe,
+                    build_key_fn_type &build_key, probe_key_fn_type &probe_key, match_fn_type &on_match,
+                    std::size_t threads, std::size_t partition_bytes) {
+    constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+    threads = std::max<std::size_t>(threads, 1);
+    const hash_type hasher{};
+    const unsigned bits = join_partition_bits<key_type>(static_cast<std::size_t>(std::ranges::size(build)), threads,
+                                                        partition_bytes);
+    const auto build_parts = radix_partition<key_type>(build, build_key, hasher, bits, threads);
+    const auto probe_parts = radix_partition<key_type>(probe, probe_key, hasher, bits, threads);
+    const std::size_t partitions = std::size_t{1} << bits;
+
+    std::atomic<std::size_t> next_partition = 0;
+    parallel_for(threads, [&](std::size_t t) {
+        std::vector<std::size_t> chain; // chain[i] is the previous build row of partition with the same key
+        for (std::size_t p; (p = next_partition++) < partitions;) {
+            const std::size_t build_lo = build_parts.offsets[p], build_hi = build_parts.offsets[p + 1];
+            const std::size_t probe_lo = probe_parts.offsets[p], probe_hi = probe_parts.offsets[p + 1];
+            if (build_lo == build_hi || probe_lo == probe_hi)
+                continue;
+            hash_table<key_type, std::size_t, hash_type> heads{next_power_of_two_inclusive(2 * (build_hi - build_lo) + 2)};
+            chain.assign(build_hi - build_lo, npos);
+            for (std::size_t i = 0; i < build_hi - build_lo; ++i) {
+                auto const &key = build_parts.entries[build_lo + i].key;
+                if (auto it = heads.find(key); it != heads.end())
+                    chain[i] = std::exchange(it->second, i);
+                else
+                    heads.emplace(key, i);
+            }
+            for (std::size_t i = probe_lo; i < probe_hi; ++i) {
+                auto const &entry = probe_parts.entries[i];
+                const auto it = heads.find(entry.key);
+                if (it == heads.end())
+                    continue;
+                for (std::size_t j = it->second; j != npos; j = chain[j])
+                    on_match(t, build_parts.entries[build_lo + j].index, entry.index);
+            }
+        }
+    });
+}
+} // namespace detail
+
+/**
+ * @brief equi-join of build and probe, both are radix partitioned by key hash so every partition of build
+ * fits in cache, then partitions are joined in parallel with a small hash_table each
+ * @param build_key maps an element of build to its key
+ * @param probe_key maps an element of probe to a key comparable with the build keys
+ * @param on_match called as on_match(build index, probe index) for every pair of elements with equal keys
+ * @param partition_bytes target memory footprint of a single build partition, should fit in l2
+ * @note on_match is called concurrently from up to threads threads
+ */
+template<std::ranges::random_access_range build_range_type, std::ranges::random_access_range probe_range_type,
+         class build_key_fn_type, class probe_key_fn_type, class match_fn_type,
+         class key_type = std::remove_cvref_t<std::invoke_result_t<build_key_fn_type &, std::ranges::range_reference_t<build_range_type const>>>,
+         class hash_type = std::hash<key_type>>
+void hash_join(build_range_type const &build, probe_range_type const &probe,
+               build_key_fn_type build_key, probe_key_fn_type probe_key, match_fn_type on_match,
+               std::size_t threads = default_thread_count(), std::size_t partition_bytes = 1 << 18) {
+    auto match = [&](std::size_t, std::size_t build_idx, std::size_t probe_idx) { on_match(build_idx, probe_idx); };
+    detail::hash_join_impl<key_type, hash_type>(build, probe, build_key, probe_key, match, threads, partition_bytes);
+}
+
+/**
+ * @brief equi-join of build and probe like hash_join, matches are collected into one batch per thread
+ * @return (build index, probe index) of every pair of elements with equal keys
+ */
+template<std::ranges::random_access_range build_range_type, std::ranges::random_access_range probe_range_type,
+         class build_key_fn_type, class probe_key_fn_type,
+         class key_type = std::remove_cvref_t<std::invoke_result_t<build_key_fn_type &, std::ranges::range_reference_t<build_range_type const>>>,
+         class hash_type = std::hash<key_type>>
+std::vector<std::pair<std::size_t, std::size_t>>
+hash_join_indices(build_range_type const &build, probe_range_type const &probe,
+                  build_key_fn_type build_key, probe_key_fn_type probe_key,
+                  std::size_t threads = default_thread_count(), std::size_t partition_bytes = 1 << 18) {
+    threads = std::max<std::size_t>(threads, 1);
+    std::vector<std::vector<std::pair<std::size_t, std::size_t>>> batches(threads);
+    auto match = [&](std::size_t t, std::size_t build_idx, std::size_t probe_idx) {
+        batches[t].emplace_back(build_idx, probe_idx);
+    };
+    detail::hash_join_impl<key_type, hash_type>(build, probe, build_key, probe_key, match, threads, partition_bytes);
+    std::size_t total = 0;
+    for (auto const &batch: batches)
+        total += batch.size();
+    std::vector<std::pair<std::size_t, std::size_t>> result;
+    result.reserve(total);
+    for (auto const &batch: batches)
+        result.insert(result.end(), batch.begin(), batch.end());
+    return result;
+}
+} // namespace lmj
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace lmj {
+/**
+ * @return number of threads to use by default, at least 1
+ */
+inline std::size_t default_thread_count() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/**
+ * @brief calls f(i) for every i in [0, threads), each on its own thread, and waits for all of them
+ * @note f(0) runs on the calling thread, exceptions thrown by any call are rethrown
+ */
+template<class F>
+void parallel_for(std::size_t threads, F &&f) {
+    std::vector<std::future<void>> futures;
+    futures.reserve(threads);
+    for (std::size_t i = 1; i < threads; ++i)
+        futures.push_back(std::async(std::launch::async, [&f, i] { f(i); }));
+    if (threads)
+        f(std::size_t{0});
+    for (auto &future: futures)
+        future.get();
+}
+} // namespace lmj
@@ -0,0 +1,487 @@
+#include "include_all.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+template<class T>
+void do_not_optimize(T const &value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+void bench_bloom_filter() {
+    constexpr std::size_t n = 1 << 22;
+    lmj::print("bloom_filter: target fpr, measured fpr, bits per key, bytes, add ns/key, query ns/key");
+    std::vector<std::uint64_t> keys(n), absent(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        keys[i] = lmj::rand<std::uint64_t>() | 1;
+        absent[i] = lmj::rand<std::uint64_t>() & ~std::uint64_t{1};
+    }
+    for (double target: {0.1, 0.01, 0.001, 0.0001}) {
+        lmj::bloom_filter<std::uint64_t> filter{n, target};
+        lmj::timer add_timer{false};
+        filter.add_many(keys.begin(), keys.end());
+        const double add_ns = add_timer.elapsed() * 1e9 / n;
+        std::vector<char> found(n);
+        lmj::timer query_timer{false};
+        filter.maybe_contains_many(absent.begin(), absent.end(), found.begin());
+        const double query_ns = query_timer.elapsed() * 1e9 / n;
+        std::size_t false_positives = 0;
+        for (char f: found)
+            false_positives += f;
+        lmj::print(target, static_cast<double>(false_positives) / n,
+                   static_cast<double>(filter.memory_usage() * 8) / n, filter.memory_usage(), add_ns, query_ns);
+    }
+    lmj::hash_table<std::uint64_t, std::uint64_t> table;
+    lmj::bloom_filtered<lmj::hash_table<std::uint64_t, std::uint64_t>> filtered{n};
+    for (std::size_t i = 0; i < n; ++i)
+        table[keys[i]] = filtered[keys[i]] = i;
+    std::size_t hits = 0;
+    lmj::timer table_timer{false};
+    for (auto key: absent)
+        hits += table.contains(key);
+    const double table_ns = table_timer.elapsed() * 1e9 / n;
+    lmj::timer filtered_timer{false};
+    for (auto key: absent)
+        hits += filtered.contains(key);
+    const double filtered_ns = filtered_timer.elapsed() * 1e9 / n;
+    do_not_optimize(hits);
+    lmj::print("hash_table miss ns/key:", table_ns, "bloom_filtered miss ns/key:", filtered_ns);
+}
+
+void bench_aggregate() {
+    constexpr std::size_t n = 1 << 24;
+    lmj::print("aggregate: threads, seconds, speedup");
+    std::vector<std::uint32_t> keys(n);
+    for (auto &key: keys)
+        key = lmj::randint<std::uint32_t>(0, 1 << 20);
+    double single_thread = 0;
+    for (std::size_t threads = 1; threads <= lmj::default_thread_count(); threads *= 2) {
+        lmj::timer t{false};
+        auto counts = lmj::aggregate<std::uint64_t>(
+                keys, [](std::uint32_t key) { return key; }, [](std::uint64_t &acc, std::uint32_t) { ++acc; }, threads);
+        const double elapsed = t.elapsed();
+        do_not_optimize(counts.size());
+        if (threads == 1)
+            single_thread = elapsed;
+        lmj::print(threads, elapsed, single_thread / elapsed);
+    }
+}
+
+void bench_hash_join() {
+    constexpr std::size_t n = 1 << 22;
+    lmj::print("hash_join: threads, partitioned seconds, single table seconds");
+    std::vector<std::uint64_t> build(n), probe(n);
+    for (auto &key: build)
+        key = lmj::randint<std::uint64_t>(0, n * 4);
+    for (auto &key: probe)
+        key = lmj::randint<std::uint64_t>(0, n * 4);
+    auto identity = [](std::uint64_t x) { return x; };
+    lmj::timer single_timer{false};
+    lmj::hash_table<std::uint64_t, std::size_t> table;
+    for (std::size_t i = 0; i < n; ++i)
+        table[build[i]] = i;
+    std::size_t single_matches = 0;
+    for (auto key: probe)
+        single_matches += table.contains(key);
+    const double single_elapsed = single_timer.elapsed();
+    do_not_optimize(single_matches);
+    for (std::size_t threads = 1; threads <= lmj::default_thread_count(); threads *= 2) {
+        std::atomic<std::size_t> matches = 0;
+        lmj::timer t{false};
+        lmj::hash_join(build, probe, identity, identity, [&](std::size_t, std::size_t) {
+            matches.fetch_add(1, std::memory_order_relaxed);
+        }, threads);
+        lmj::print(threads, t.elapsed(), single_elapsed);
+        do_not_optimize(matches.load());
+    }
+}
+
+void bench_generation_clear() {
+    constexpr std::size_t rounds = 1 << 14;
+    lmj::print("clear of a 2^16 slot scratch table holding 8 elements: plain ns/round, generational ns/round");
+    auto run = [](auto &table) {
+        table.reserve(1 << 15);
+        lmj::timer t{false};
+        for (std::size_t round = 0; round < rounds; ++round) {
+            for (std::uint32_t i = 0; i < 8; ++i)
+                table[lmj::rand<std::uint32_t>()] = i;
+            do_not_optimize(table.size());
+            table.clear();
+        }
+        return t.elapsed() * 1e9 / rounds;
+    };
+    lmj::hash_table<std::uint32_t, std::uint32_t> plain;
+    lmj::hash_table<std::uint32_t, std::uint32_t, std::hash<std::uint32_t>, lmj::default_growth_policy, std::uint16_t> generational;
+    const double plain_ns = run(plain);
+    lmj::print(plain_ns, run(generational));
+}
+
+void bench_hopscotch_latency() {
+    constexpr std::size_t capacity = 1 << 14, size = capacity * 85 / 100, lookups = 1 << 18;
+    lmj::print("lookup latency after churn at 85% load: table, p50 ns, p99 ns, max ns");
+    auto run = [&](char const *name, auto &table, auto insert, auto erase, auto contains) {
+        std::vector<std::uint64_t> keys;
+        while (keys.size() < size) {
+            const auto key = lmj::rand<std::uint64_t>();
+            if (insert(table, key))
+                keys.push_back(key);
+        }
+        for (std::size_t i = 0; i < capacity * 4; ++i) {
+            const auto victim = lmj::randint<std::size_t>(0, keys.size() - 1);
+            erase(table, keys[victim]);
+            do
+                keys[victim] = lmj::rand<std::uint64_t>();
+            while (!insert(table, keys[victim]));
+        }
+        std::vector<double> latencies(lookups);
+        std::size_t hits = 0;
+        for (auto &latency: latencies) {
+            const auto key = lmj::randint(0, 1) ? keys[lmj::randint<std::size_t>(0, keys.size() - 1)] : lmj::rand<std::uint64_t>();
+            const auto start = std::chrono::steady_clock::now();
+            hits += contains(table, key);
+            latency = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        }
+        do_not_optimize(hits);
+        std::sort(latencies.begin(), latencies.end());
+        lmj::print(name, latencies[lookups / 2], latencies[lookups * 99 / 100], latencies.back());
+    };
+    auto linear = std::make_unique<lmj::static_hash_table<std::uint64_t, std::uint64_t, capacity>>();
+    run("static_hash_table", *linear,
+        [](auto &t, std::uint64_t key) { return !t.contains(key) && (t[key] = key, true); },
+        [](auto &t, std::uint64_t key) { t.erase(key); },
+        [](auto const &t, std::uint64_t key) { return t.contains(key); });
+    auto hopscotch = std::make_unique<lmj::static_hopscotch_table<std::uint64_t, std::uint64_t, capacity, 64>>();
+    run("static_hopscotch_table", *hopscotch,
+        [](auto &t, std::uint64_t key) { return t.insert(key, key); },
+        [](auto &t, std::uint64_t key) { t.erase(key); },
+        [](auto const &t, std::uint64_t key) { return t.contains(key); });
+}
+
+void bench_seqlock_table_readers() {
+    constexpr std::size_t capacity = 1 << 14, size = capacity / 2, lookups = 1 << 22;
+    lmj::print("seqlock_static_hash_table with a busy writer: reader threads, million lookups per second per reader, total");
+    auto table = std::make_unique<lmj::seqlock_static_hash_table<std::uint64_t, std::uint64_t, capacity>>();
+    std::vector<std::uint64_t> keys(size);
+    for (auto &key: keys) {
+        key = lmj::rand<std::uint64_t>();
+        table->insert_or_assign(key, key);
+    }
+    for (std::size_t threads = 1; threads <= lmj::default_thread_count(); threads *= 2) {
+        std::atomic<bool> done = false;
+        auto writer = std::async(std::launch::async, [&] {
+            for (std::uint64_t i = 0; !done; ++i)
+                table->insert_or_assign(keys[i % size], i);
+        });
+        std::vector<std::future<double>> readers;
+        for (std::size_t r = 0; r < threads; ++r) {
+            readers.push_back(std::async(std::launch::async, [&] {
+                lmj::timer t{false};
+                std::uint64_t sum = 0;
+                for (std::size_t i = 0; i < lookups; ++i)
+                    sum += table->find(keys[(i * 7919) % size]).value_or(0);
+                do_not_optimize(sum);
+                return lookups / t.elapsed() / 1e6;
+            }));
+        }
+        double total = 0;
+        for (auto &reader: readers)
+            total += reader.get();
+        done = true;
+        writer.get();
+        lmj::print(threads, total / static_cast<double>(threads), total);
+    }
+}
+
+template<std::size_t n>
+void bench_flat_table_size() {
+    constexpr std::size_t lookups = 1 << 22;
+    auto pairs = std::make_unique<std::array<std::pair<std::uint64_t, std::uint64_t>, n>>();
+    auto hashed = std::make_unique<lmj::static_hash_table<std::uint64_t, std::uint64_t, 2 * n>>();
+    for (auto &[key, value]: *pairs) {
+        do
+            key = lmj::rand<std::uint64_t>();
+        while (hashed->contains(key));
+        value = key;
+        hashed->insert({key, value});
+    }
+    auto flat = std::make_unique<lmj::static_flat_table<std::uint64_t, std::uint64_t, n>>(*pairs);
+    std::vector<std::uint64_t> queries(lookups);
+    for (auto &query: queries)
+        query = (*pairs)[lmj::randint<std::size_t>(0, n - 1)].first;
+    std::uint64_t sum = 0;
+    lmj::timer flat_timer{false};
+    for (std::uint64_t query: queries)
+        sum += flat->find(query).value();
+    const double flat_ns = flat_timer.elapsed() * 1e9 / lookups;
+    lmj::timer hashed_timer{false};
+    for (std::uint64_t query: queries)
+        sum += hashed->at(query);
+    const double hashed_ns = hashed_timer.elapsed() * 1e9 / lookups;
+    do_not_optimize(sum);
+    lmj::print(n, flat_ns, hashed_ns);
+}
+
+void bench_flat_table() {
+    lmj::print("static_flat_table vs static_hash_table lookups: entries, flat ns, hashed ns");
+    bench_flat_table_size<16>();
+    bench_flat_table_size<256>();
+    bench_flat_table_size<4096>();
+    bench_flat_table_size<1 << 16>();
+}
+
+void bench_static_vector_append() {
+    constexpr std::size_t packets = 1 << 20, span_size = 48;
+    lmj::print("static_vector<uint8_t, 1500> packet of 30 spans: ns per packet with push_back, with append_range");
+    std::vector<std::uint8_t> payload(span_size);
+    for (auto &byte: payload)
+        byte = lmj::rand<std::uint8_t>();
+    lmj::static_vector<std::uint8_t, 1500> packet;
+    std::uint64_t sum = 0;
+    lmj::timer push_timer{false};
+    for (std::size_t i = 0; i < packets; ++i) {
+        packet.clear();
+        for (std::size_t span = 0; span < 30; ++span)
+            for (std::uint8_t byte: payload)
+                packet.push_back(byte);
+        sum += packet.back();
+        do_not_optimize(packet);
+    }
+    const double push_ns = push_timer.elapsed() * 1e9 / packets;
+    lmj::timer append_timer{false};
+    for (std::size_t i = 0; i < packets; ++i) {
+        packet.clear();
+        for (std::size_t span = 0; span < 30; ++span)
+            packet.append_range(payload);
+        sum += packet.back();
+        do_not_optimize(packet);
+    }
+    const double append_ns = append_timer.elapsed() * 1e9 / packets;
+    do_not_optimize(sum);
+    lmj::print(push_ns, append_ns);
+}
+
+template<std::size_t n>
+void bench_flat_map_size() {
+    constexpr std::size_t lookups = 1 << 22;
+    lmj::flat_map<std::uint64_t, std::uint64_t, n> flat;
+    lmj::static_hash_table<std::uint64_t, std::uint64_t, 2 * n> hashed;
+    std::vector<std::uint64_t> keys;
+    while (keys.size() < n) {
+        const auto key = lmj::rand<std::uint64_t>();
+        if (flat.insert_or_assign(key, key)) {
+            hashed[key] = key;
+            keys.push_back(key);
+        }
+    }
+    std::vector<std::uint64_t> queries(lookups);
+    for (auto &query: queries)
+        query = keys[lmj::randint<std::size_t>(0, n - 1)];
+    std::uint64_t sum = 0;
+    lmj::timer flat_timer{false};
+    for (std::uint64_t query: queries)
+        sum += *flat.find(query);
+    const double flat_ns = flat_timer.elapsed() * 1e9 / lookups;
+    lmj::timer hashed_timer{false};
+    for (std::uint64_t query: queries)
+        sum += hashed.at(query);
+    const double hashed_ns = hashed_timer.elapsed() * 1e9 / lookups;
+    do_not_optimize(sum);
+    lmj::print(n, flat_ns, hashed_ns);
+}
+
+void bench_flat_map() {
+    lmj::print("flat_map vs static_hash_table lookups: entries, flat ns, hashed ns");
+    bench_flat_map_size<4>();
+    bench_flat_map_size<8>();
+    bench_flat_map_size<16>();
+    bench_flat_map_size<32>();
+    bench_flat_map_size<64>();
+    bench_flat_map_size<128>();
+    bench_flat_map_size<256>();
+}
+
+void bench_spsc_queue() {
+    constexpr std::size_t count = 1 << 22, batch_size = 32;
+    lmj::print("spsc_queue<uint64_t, 1024> handoff between two threads: ns per element single, batched, mutex + deque");
+    auto queue = std::make_unique<lmj::spsc_queue<std::uint64_t, 1024>>();
+    auto transfer = [&](std::size_t n, auto push, auto pop) {
+        lmj::timer t{false};
+        auto producer = std::async(std::launch::async, [&] {
+            for (std::uint64_t i = 0; i < n;)
+                i += push(i);
+        });
+        std::uint64_t sum = 0;
+        for (std::uint64_t i = 0; i < n;)
+            i += pop(sum);
+        producer.get();
+        do_not_optimize(sum);
+        return t.elapsed() * 1e9 / static_cast<double>(n);
+    };
+    const double single_ns = transfer(
+            count,
+            [&](std::uint64_t i) -> std::size_t {
+                if (queue->try_push(i))
+                    return 1;
+                std::this_thread::yield();
+                return 0;
+            },
+            [&](std::uint64_t &sum) -> std::size_t {
+                if (auto value = queue->try_pop()) {
+                    sum += *value;
+                    return 1;
+                }
+                std::this_thread::yield();
+                return 0;
+            });
+    const double batched_ns = transfer(
+            count,
+            [&](std::uint64_t i) {
+                std::array<std::uint64_t, batch_size> batch;
+                std::iota(batch.begin(), batch.end(), i);
+                const std::size_t pushed = queue->push_n(batch.begin(), std::min<std::size_t>(batch_size, count - i));
+                if (!pushed)
+                    std::this_thread::yield();
+                return pushed;
+            },
+            [&](std::uint64_t &sum) {
+                std::array<std::uint64_t, batch_size> batch;
+                const std::size_t popped = queue->pop_n(batch.begin(), batch_size);
+                if (!popped)
+                    std::this_thread::yield();
+                for (std::size_t i = 0; i < popped; ++i)
+                    sum += batch[i];
+                return popped;
+            });
+    std::mutex mutex;
+    std::deque<std::uint64_t> deque;
+    const double mutex_ns = transfer(
+            count / 64,
+            [&](std::uint64_t i) -> std::size_t {
+                std::lock_guard lock{mutex};
+                if (deque.size() == queue->capacity())
+                    return 0;
+                deque.push_back(i);
+                return 1;
+            },
+            [&](std::uint64_t &sum) -> std::size_t {
+                std::lock_guard lock{mutex};
+                if (deque.empty())
+                    return 0;
+                sum += deque.front();
+                deque.pop_front();
+                return 1;
+            });
+    lmj::print(single_ns, batched_ns, mutex_ns);
+}
+
+void bench_mpmc_queue() {
+    constexpr std::uint64_t count = 1 << 20;
+    lmj::print("mpmc_queue<uint64_t, 1024> with blocking push and pop: producers, consumers, million elements per second");
+    auto queue = std::make_unique<lmj::mpmc_queue<std::uint64_t, 1024>>();
+    for (auto [producers, consumers]: {std::pair{1, 1}, {1, 4}, {4, 1}, {2, 2}, {4, 4}, {8, 8}}) {
+        lmj::timer t{false};
+        std::atomic<std::uint64_t> sum = 0;
+        std::vector<std::future<void>> threads;
+        for (int p = 0; p < producers; ++p)
+            threads.push_back(std::async(std::launch::async, [&, p] {
+                for (std::uint64_t i = static_cast<std::uint64_t>(p); i < count; i += static_cast<std::uint64_t>(producers))
+                    queue->push(i);
+            }));
+        for (int c = 0; c < consumers; ++c)
+            threads.push_back(std::async(std::launch::async, [&, c] {
+                std::uint64_t local = 0;
+                for (std::uint64_t i = static_cast<std::uint64_t>(c); i < count; i += static_cast<std::uint64_t>(consumers))
+                    local += queue->pop();
+                sum += local;
+            }));
+        for (auto &thread: threads)
+            thread.get();
+        do_not_optimize(sum.load());
+        lmj::print(producers, consumers, static_cast<double>(count) / t.elapsed() / 1e6);
+    }
+}
+
+void bench_rank_select() {
+    constexpr std::size_t n = 1 << 26, queries = 1 << 22;
+    lmj::print("rank_select over 2^26 bits: density, overhead %, rank1 ns, select1 ns, linear popcount rank ns");
+    for (const int percent: {1, 50, 90}) {
+        lmj::bitvector bits(n);
+        for (std::size_t i = 0; i < n; ++i)
+            bits.set(i, lmj::randint(0, 99) < percent);
+        const lmj::rank_select index{bits};
+        std::vector<std::size_t> positions(queries), ranks(queries);
+        for (std::size_t i = 0; i < queries; ++i) {
+            positions[i] = lmj::randint<std::size_t>(0, n);
+            ranks[i] = lmj::randint<std::size_t>(0, index.ones() - 1);
+        }
+        std::size_t sum = 0;
+        lmj::timer rank_timer{false};
+        for (std::size_t i: positions)
+            sum += index.rank1(i);
+        const double rank_ns = rank_timer.elapsed() * 1e9 / queries;
+        lmj::timer select_timer{false};
+        for (std::size_t k: ranks)
+            sum += index.select1(k);
+        const double select_ns = select_timer.elapsed() * 1e9 / queries;
+        // without the directory a rank popcounts every word before the position
+        constexpr std::size_t linear_queries = 1 << 8;
+        lmj::timer linear_timer{false};
+        for (std::size_t i = 0; i < linear_queries; ++i)
+            sum += lmj::detail::popcount_words(bits.words().data(), positions[i] / 64);
+        const double linear_ns = linear_timer.elapsed() * 1e9 / linear_queries;
+        do_not_optimize(sum);
+        lmj::print(percent, 100.0 * static_cast<double>(index.overhead_bytes()) / (n / 8), rank_ns, select_ns, linear_ns);
+    }
+}
+
+void bench_inplace_function() {
+    constexpr std::size_t count = 1 << 22;
+    lmj::print("task dispatch through an mpmc_queue with a 40 byte capture: ns per task std::function, inplace_function");
+    auto dispatch = [&]<class task>() {
+        auto queue = std::make_unique<lmj::mpmc_queue<task, 256>>();
+        std::uint64_t sum = 0;
+        lmj::timer t{false};
+        for (std::size_t i = 0; i < count; i += 256) {
+            for (std::uint64_t j = 0; j < 256; ++j) {
+                const std::array<std::uint64_t, 4> payload{i, j, i ^ j, i + j};
+                queue->try_push([payload, &sum] { sum += payload[0] + payload[1] + payload[2] + payload[3]; });
+            }
+            while (auto next = queue->try_pop())
+                (*next)();
+        }
+        do_not_optimize(sum);
+        return t.elapsed() * 1e9 / count;
+    };
+    const double function_ns = dispatch.operator()<std::function<void()>>();
+    const double inplace_ns = dispatch.operator()<lmj::inplace_function<void()>>();
+    lmj::print(function_ns, inplace_ns);
+}
+} // namespace
+
+int main() {
+    bench_bloom_filter();
+    bench_aggregate();
+    bench_hash_join();
+    bench_generation_clear();
+    bench_hopscotch_latency();
+    bench_seqlock_table_readers();
+    bench_flat_table();
+    bench_static_vector_append();
+    bench_flat_map();
+    bench_spsc_queue();
+    bench_mpmc_queue();
+    bench_rank_select();
+    bench_inplace_function();
+}
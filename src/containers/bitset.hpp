@@ -0,0 +1,606 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <initializer_list>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+namespace lmj {
+namespace detail {
+inline constexpr std::size_t word_bits = 64;
+
+/**
+ * @return number of 64 bit words holding bits bits
+ */
+constexpr std::size_t words_for(std::size_t bits) {
+    return (bits + word_bits - 1) / word_bits;
+}
+
+/**
+ * @return the last word of a bitset of bits bits with its unused high bits cleared
+ */
+constexpr std::uint64_t last_word_mask(std::size_t bits) {
+    return bits % word_bits ? (std::uint64_t{1} << bits % word_bits) - 1 : ~std::uint64_t{0};
+}
+
+/**
+ * @return number of set bits in the n words
+ */
+constexpr std::size_t popcount_words(std::uint64_t const *words, std::size_t n) {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < n; ++i)
+        count += static_cast<std::size_t>(std::popcount(words[i]));
+    return count;
+}
+
+/**
+ * @return index of the first set bit at or after pos, or bits if there is none
+ * @note bits past the end must be zero
+ */
+constexpr std::size_t find_set_bit(std::uint64_t const *words, std::size_t bits, std::size_t pos) {
+    if (pos >= bits)
+        return bits;
+    std::size_t word = pos / word_bits;
+    std::uint64_t w = words[word] & (~std::uint64_t{0} << pos % word_bits);
+    while (!w) {
+        if (++word == words_for(bits))
+            return bits;
+        w = words[word];
+    }
+    return word * word_bits + static_cast<std::size_t>(std::countr_zero(w));
+}
+
+/**
+ * @brief calls f(index) for every set bit in ascending order, clearing the lowest bit of a copy of each word
+ */
+template<class F>
+constexpr void for_each_set_bit(std::uint64_t const *words, std::size_t n, F &&f) {
+    for (std::size_t i = 0; i < n; ++i)
+        for (std::uint64_t w = words[i]; w; w &= w - 1)
+            f(i * word_bits + static_cast<std::size_t>(std::countr_zero(w)));
+}
+
+/**
+ * @return position of the k-th set bit of w counting from 0, w must have more than k set bits
+ * @note a single pdep with BMI2
+ */
+constexpr unsigned select_in_word(std::uint64_t w, unsigned k) {
+#if defined(__BMI2__)
+    if (!std::is_constant_evaluated())
+        return static_cast<unsigned>(std::countr_zero(_pdep_u64(std::uint64_t{1} << k, w)));
+#endif
+    for (; k; --k)
+        w &= w - 1;
+    return static_cast<unsigned>(std::countr_zero(w));
+}
+} // namespace detail
+
+/**
+ * fixed size bitset stored inline in 64 bit words, unlike std::bitset it is usable in constant expressions,
+ * exposes its words and finds set bits with std::countr_zero a word at a time
+ * @note bits past _size are always zero, so counting and searching never mask
+ */
+template<std::size_t _size>
+class static_bitset {
+    static_assert(_size && "empty static_bitset");
+
+public:
+    using size_type = std::size_t;
+    using word_type = std::uint64_t;
+
+    static constexpr size_type word_count = detail::words_for(_size);
+
+    word_type m_words[word_count]{};
+
+    constexpr static_bitset() = default;
+
+    /**
+     * @param positions indices of the bits to set
+     */
+    constexpr static_bitset(std::initializer_list<size_type> positions) {
+        for (size_type i: positions)
+            set(i);
+    }
+
+    [[nodiscard]] constexpr bool test(size_type i) const {
+        assert(i < _size && "bit out of range");
+        return m_words[i / detail::word_bits] >> i % detail::word_bits & 1;
+    }
+
+    [[nodiscard]] constexpr bool operator[](size_type i) const {
+        return test(i);
+    }
+
+    constexpr static_bitset &set(size_type i) {
+        assert(i < _size && "bit out of range");
+        m_words[i / detail::word_bits] |= word_type{1} << i % detail::word_bits;
+        return *this;
+    }
+
+    constexpr static_bitset &set(size_type i, bool value) {
+        return value ? set(i) : reset(i);
+    }
+
+    constexpr static_bitset &reset(size_type i) {
+        assert(i < _size && "bit out of range");
+        m_words[i / detail::word_bits] &= ~(word_type{1} << i % detail::word_bits);
+        return *this;
+    }
+
+    constexpr static_bitset &flip(size_type i) {
+        assert(i < _size && "bit out of range");
+        m_words[i / detail::word_bits] ^= word_type{1} << i % detail::word_bits;
+        return *this;
+    }
+
+    /**
+     * @brief sets every bit
+     */
+    constexpr static_bitset &set() {
+        std::fill_n(m_words, word_count, ~word_type{0});
+        _trim();
+        return *this;
+    }
+
+    /**
+     * @brief clears every bit
+     */
+    constexpr static_bitset &reset() {
+        std::fill_n(m_words, word_count, word_type{0});
+        return *this;
+    }
+
+    /**
+     * @brief flips every bit
+     */
+    constexpr static_bitset &flip() {
+        for (auto &word: m_words)
+            word = ~word;
+        _trim();
+        return *this;
+    }
+
+    /**
+     * @return number of set bits
+     */
+    [[nodiscard]] constexpr size_type count() const {
+        return detail::popcount_words(m_words, word_count);
+    }
+
+    [[nodiscard]] constexpr bool any() const {
+        return std::any_of(m_words, m_words + word_count, [](word_type w) { return w != 0; });
+    }
+
+    [[nodiscard]] constexpr bool none() const {
+        return !any();
+    }
+
+    [[nodiscard]] constexpr bool all() const {
+        return count() == _size;
+    }
+
+    /**
+     * @return index of the first set bit or size()
+     */
+    [[nodiscard]] constexpr size_type find_first() const {
+        return detail::find_set_bit(m_words, _size, 0);
+    }
+
+    /**
+     * @return index of the first set bit after i or size()
+     */
+    [[nodiscard]] constexpr size_type find_next(size_type i) const {
+        return detail::find_set_bit(m_words, _size, i + 1);
+    }
+
+    /**
+     * @brief calls f(index) for every set bit in ascending order
+     */
+    template<class F>
+    constexpr void for_each_set(F &&f) const {
+        detail::for_each_set_bit(m_words, word_count, std::forward<F>(f));
+    }
+
+    [[nodiscard]] static constexpr size_type size() { return _size; }
+
+    [[nodiscard]] constexpr std::span<word_type const> words() const { return m_words; }
+
+    constexpr static_bitset &operator&=(static_bitset const &other) {
+        for (size_type i = 0; i < word_count; ++i)
+            m_words[i] &= other.m_words[i];
+        return *this;
+    }
+
+    constexpr static_bitset &operator|=(static_bitset const &other) {
+        for (size_type i = 0; i < word_count; ++i)
+            m_words[i] |= other.m_words[i];
+        return *this;
+    }
+
+    constexpr static_bitset &operator^=(static_bitset const &other) {
+        for (size_type i = 0; i < word_count; ++i)
+            m_words[i] ^= other.m_words[i];
+        return *this;
+    }
+
+    [[nodiscard]] constexpr static_bitset operator~() const {
+        return static_bitset{*this}.flip();
+    }
+
+    [[nodiscard]] friend constexpr static_bitset operator&(static_bitset lhs, static_bitset const &rhs) {
+        return lhs &= rhs;
+    }
+
+    [[nodiscard]] friend constexpr static_bitset operator|(static_bitset lhs, static_bitset const &rhs) {
+        return lhs |= rhs;
+    }
+
+    [[nodiscard]] friend constexpr static_bitset operator^(static_bitset lhs, static_bitset const &rhs) {
+        return lhs ^= rhs;
+    }
+
+    [[nodiscard]] constexpr bool operator==(static_bitset const &other) const {
+        return std::equal(m_words, m_words + word_count, other.m_words);
+    }
+
+private:
+    constexpr void _trim() {
+        m_words[word_count - 1] &= detail::last_word_mask(_size);
+    }
+};
+
+/**
+ * growable bitset in a std::vector of 64 bit words, a compact membership set for dense id ranges
+ * @note bits past size() are always zero, so counting and searching never mask
+ */
+class bitvector {
+public:
+    using size_type = std::size_t;
+    using word_type = std::uint64_t;
+
+    std::vector<word_type> m_words;
+    size_type m_size = 0;
+
+    constexpr bitvector() = default;
+
+    constexpr explicit bitvector(size_type n, bool value = false)
+            : m_words(detail::words_for(n), value ? ~word_type{0} : word_type{0}), m_size{n} {
+        _trim();
+    }
+
+    [[nodiscard]] constexpr bool test(size_type i) const {
+        assert(i < m_size && "bit out of range");
+        return m_words[i / detail::word_bits] >> i % detail::word_bits & 1;
+    }
+
+    [[nodiscard]] constexpr bool operator[](size_type i) const {
+        return test(i);
+    }
+
+    constexpr bitvector &set(size_type i) {
+        assert(i < m_size && "bit out of range");
+        m_words[i / detail::word_bits] |= word_type{1} << i % detail::word_bits;
+        return *this;
+    }
+
+    constexpr bitvector &set(size_type i, bool value) {
+        return value ? set(i) : reset(i);
+    }
+
+    constexpr bitvector &reset(size_type i) {
+        assert(i < m_size && "bit out of range");
+        m_words[i / detail::word_bits] &= ~(word_type{1} << i % detail::word_bits);
+        return *this;
+    }
+
+    constexpr bitvector &flip(size_type i) {
+        assert(i < m_size && "bit out of range");
+        m_words[i / detail::word_bits] ^= word_type{1} << i % detail::word_bits;
+        return *this;
+    }
+
+    /**
+     * @brief sets every bit
+     */
+    constexpr bitvector &set() {
+        std::fill(m_words.begin(), m_words.end(), ~word_type{0});
+        _trim();
+        return *this;
+    }
+
+    /**
+     * @brief clears every bit
+     */
+    constexpr bitvector &reset() {
+        std::fill(m_words.begin(), m_words.end(), word_type{0});
+        return *this;
+    }
+
+    /**
+     * @brief flips every bit
+     */
+    constexpr bitvector &flip() {
+        for (auto &word: m_words)
+            word = ~word;
+        _trim();
+        return *this;
+    }
+
+    constexpr void push_back(bool value) {
+        if (m_size % detail::word_bits == 0)
+            m_words.push_back(0);
+        ++m_size;
+        set(m_size - 1, value);
+    }
+
+    /**
+     * @brief new bits are set to value
+     */
+    constexpr void resize(size_type n, bool value = false) {
+        if (value && n > m_size && m_size % detail::word_bits)
+            m_words.back() |= ~detail::last_word_mask(m_size);
+        m_words.resize(detail::words_for(n), value ? ~word_type{0} : word_type{0});
+        m_size = n;
+        _trim();
+    }
+
+    constexpr void reserve(size_type n) {
+        m_words.reserve(detail::words_for(n));
+    }
+
+    constexpr void clear() {
+        m_words.clear();
+        m_size = 0;
+    }
+
+    /**
+     * @return number of set bits
+     */
+    [[nodiscard]] constexpr size_type count() const {
+        return detail::popcount_words(m_words.data(), m_words.size());
+    }
+
+    [[nodiscard]] constexpr bool any() const {
+        return std::any_of(m_words.begin(), m_words.end(), [](word_type w) { return w != 0; });
+    }
+
+    [[nodiscard]] constexpr bool none() const {
+        return !any();
+    }
+
+    [[nodiscard]] constexpr bool all() const {
+        return count() == m_size;
+    }
+
+    /**
+     * @return index of the first set bit or size()
+     */
+    [[nodiscard]] constexpr size_type find_first() const {
+        return detail::find_set_bit(m_words.data(), m_size, 0);
+    }
+
+    /**
+     * @return index of the first set bit after i or size()
+     */
+    [[nodiscard]] constexpr size_type find_next(size_type i) const {
+        return detail::find_set_bit(m_words.data(), m_size, i + 1);
+    }
+
+    /**
+     * @brief calls f(index) for every set bit in ascending order
+     */
+    template<class F>
+    constexpr void for_each_set(F &&f) const {
+        detail::for_each_set_bit(m_words.data(), m_words.size(), std::forward<F>(f));
+    }
+
+    [[nodiscard]] constexpr size_type size() const { return m_size; }
+
+    [[nodiscard]] constexpr bool empty() const { return m_size == 0; }
+
+    [[nodiscard]] constexpr std::span<word_type const> words() const { return m_words; }
+
+    constexpr bitvector &operator&=(bitvector const &other) {
+        assert(m_size == other.m_size && "bitvectors of different sizes");
+        for (size_type i = 0; i < m_words.size(); ++i)
+            m_words[i] &= other.m_words[i];
+        return *this;
+    }
+
+    constexpr bitvector &operator|=(bitvector const &other) {
+        assert(m_size == other.m_size && "bitvectors of different sizes");
+        for (size_type i = 0; i < m_words.size(); ++i)
+            m_words[i] |= other.m_words[i];
+        return *this;
+    }
+
+    constexpr bitvector &operator^=(bitvector const &other) {
+        assert(m_size == other.m_size && "bitvectors of different sizes");
+        for (size_type i = 0; i < m_words.size(); ++i)
+            m_words[i] ^= other.m_words[i];
+        return *this;
+    }
+
+    [[nodiscard]] constexpr bitvector operator~() const {
+        return bitvector{*this}.flip();
+    }
+
+    [[nodiscard]] friend constexpr bitvector operator&(bitvector lhs, bitvector const &rhs) {
+        return lhs &= rhs;
+    }
+
+    [[nodiscard]] friend constexpr bitvector operator|(bitvector lhs, bitvector const &rhs) {
+        return lhs |= rhs;
+    }
+
+    [[nodiscard]] friend constexpr bitvector operator^(bitvector lhs, bitvector const &rhs) {
+        return lhs ^= rhs;
+    }
+
+    [[nodiscard]] constexpr bool operator==(bitvector const &other) const = default;
+
+private:
+    constexpr void _trim() {
+        if (!m_words.empty())
+            m_words.back() &= detail::last_word_mask(m_size);
+    }
+};
+
+/**
+ * rank and select directory over the words of a static_bitset or bitvector, one 64 bit entry per 2048 bit block
+ * holds the rank at the start of the block (relative to its 2^32 bit region) and the popcounts of its first three
+ * 512 bit sub blocks, 3.125% on top of the bits
+ * @note rank1 reads one entry and popcounts at most 8 words, select1 binary searches the blocks between two
+ * samples taken every 8192 ones, then walks at most 3 sub blocks and 8 words
+ * @note it views the words, build it again after the bits change
+ */
+class rank_select {
+public:
+    using size_type = std::size_t;
+
+    static constexpr size_type block_bits = 2048, sub_block_bits = 512, select_sample = 8192;
+    static constexpr size_type block_words = block_bits / detail::word_bits;
+    static constexpr size_type sub_block_words = sub_block_bits / detail::word_bits;
+    static constexpr size_type region_blocks = (size_type{1} << 32) / block_bits;
+
+    std::span<std::uint64_t const> m_words;
+    size_type m_size = 0;
+    size_type m_ones = 0;
+    std::vector<std::uint64_t> m_blocks;  // one more than needed so rank1(size()) needs no special case
+    std::vector<size_type> m_regions;     // rank at the start of every 2^32 bits
+    std::vector<std::uint32_t> m_samples; // block holding the (i * select_sample)-th one
+
+    template<class bits_type>
+        requires requires(bits_type const &bits) { bits.words(); bits.size(); }
+    constexpr explicit rank_select(bits_type const &bits) : rank_select(bits.words(), bits.size()) {}
+
+    /**
+     * @param words bits past size must be zero
+     */
+    constexpr rank_select(std::span<std::uint64_t const> words, size_type size)
+            : m_words{words}, m_size{size}, m_blocks(size / block_bits + 1) {
+        assert(words.size() == detail::words_for(size));
+        size_type rank = 0, next_sample = 0;
+        for (size_type b = 0; b < m_blocks.size(); ++b) {
+            if (b % region_blocks == 0)
+                m_regions.push_back(rank);
+            std::uint64_t entry = static_cast<std::uint64_t>(rank - m_regions.back()) << 32;
+            for (size_type s = 0; s < block_words / sub_block_words; ++s) {
+                const size_type first = std::min(b * block_words + s * sub_block_words, m_words.size());
+                const size_type last = std::min(first + sub_block_words, m_words.size());
+                const size_type ones = detail::popcount_words(m_words.data() + first, last - first);
+                if (s < 3)
+                    entry |= static_cast<std::uint64_t>(ones) << (10 * s);
+                rank += ones;
+            }
+            m_blocks[b] = entry;
+            for (; next_sample < rank; next_sample += select_sample)
+                m_samples.push_back(static_cast<std::uint32_t>(b));
+        }
+        m_ones = rank;
+    }
+
+    /**
+     * @return number of set bits before i, i may be size()
+     */
+    [[nodiscard]] constexpr size_type rank1(size_type i) const {
+        assert(i <= m_size && "rank past the end");
+        const std::uint64_t entry = m_blocks[i / block_bits];
+        size_type rank = _block_rank(i / block_bits);
+        for (size_type s = 0; s < i / sub_block_bits % 4; ++s)
+            rank += entry >> (10 * s) & 1023;
+        const size_type last = i / detail::word_bits;
+        for (size_type w = i / sub_block_bits * sub_block_words; w < last; ++w)
+            rank += static_cast<size_type>(std::popcount(m_words[w]));
+        if (i % detail::word_bits)
+            rank += static_cast<size_type>(std::popcount(m_words[last] & ((std::uint64_t{1} << i % detail::word_bits) - 1)));
+        return rank;
+    }
+
+    /**
+     * @return number of clear bits before i, i may be size()
+     */
+    [[nodiscard]] constexpr size_type rank0(size_type i) const {
+        return i - rank1(i);
+    }
+
+    /**
+     * @return index of the k-th set bit counting from 0, k must be less than ones()
+     */
+    [[nodiscard]] constexpr size_type select1(size_type k) const {
+        assert(k < m_ones && "not that many set bits");
+        // last block starting at or before the k-th one, it lies between the samples around k
+        size_type lo = m_samples[k / select_sample];
+        size_type hi = k / select_sample + 1 < m_samples.size() ? m_samples[k / select_sample + 1] + 1 : m_blocks.size();
+        while (hi - lo > 1) {
+            const size_type mid = lo + (hi - lo) / 2;
+            if (_block_rank(mid) <= k)
+                lo = mid;
+            else
+                hi = mid;
+        }
+        size_type remaining = k - _block_rank(lo), s = 0;
+        for (const std::uint64_t entry = m_blocks[lo]; s < 3; ++s) {
+            const size_type ones = entry >> (10 * s) & 1023;
+            if (remaining < ones)
+                break;
+            remaining -= ones;
+        }
+        for (size_type w = lo * block_words + s * sub_block_words;; ++w) {
+            const auto ones = static_cast<size_type>(std::popcount(m_words[w]));
+            if (remaining < ones)
+                return w * detail::word_bits + detail::select_in_word(m_words[w], static_cast<unsigned>(remaining));
+            remaining -= ones;
+        }
+    }
+
+    /**
+     * @return number of set bits
+     */
+    [[nodiscard]] constexpr size_type ones() const { return m_ones; }
+
+    [[nodiscard]] constexpr size_type size() const { return m_size; }
+
+    /**
+     * @return bytes used by the directory on top of the bits
+     */
+    [[nodiscard]] constexpr size_type overhead_bytes() const {
+        return m_blocks.size() * sizeof(std::uint64_t) + m_regions.size() * sizeof(size_type) +
+               m_samples.size() * sizeof(std::uint32_t);
+    }
+
+private:
+    [[nodiscard]] constexpr size_type _block_rank(size_type b) const {
+        return m_regions[b / region_blocks] + static_cast<size_type>(m_blocks[b] >> 32);
+    }
+};
+
+// tests
+static_assert([] {
+    static_bitset<130> bits = {0, 63, 64, 129};
+    static_bitset<130> other = {63, 100};
+    const auto both = bits & other, either = bits | other;
+    return bits.count() == 4 && bits.find_first() == 0 && bits.find_next(0) == 63 && bits.find_next(64) == 129 &&
+           bits.find_next(129) == 130 && both.count() == 1 && both.test(63) && either.count() == 5 &&
+           (~bits).count() == 126 && static_bitset<130>{}.set().all() && static_bitset<130>{}.none();
+}());
+static_assert([] {
+    bitvector bits(70);
+    bits.set(3).set(69);
+    bits.resize(200, true);
+    bits.push_back(false);
+    const rank_select index{bits};
+    return bits.size() == 201 && bits.count() == 132 && index.rank1(4) == 1 && index.rank1(70) == 2 &&
+           index.rank1(201) == 132 && index.select1(0) == 3 && index.select1(1) == 69 && index.select1(2) == 70 &&
+           index.select1(131) == 199;
+}());
+} // namespace lmj
@@ -0,0 +1,298 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "container_helpers.hpp"
+
+namespace lmj {
+namespace detail {
+/**
+ * @param keys_per_block average number of keys hashed into each 256 bit block
+ * @return false positive rate of a split block bloom filter
+ */
+inline double split_block_false_positive_rate(double keys_per_block) {
+    // the number of keys in a block is poisson distributed, a block holding i keys
+    // reports a false positive if all 8 probed bits (one per 32 bit word) are set
+    const double spread = 12 * std::sqrt(keys_per_block) + 32;
+    const auto lo = static_cast<std::uint64_t>(std::max(0.0, keys_per_block - spread));
+    const auto hi = static_cast<std::uint64_t>(keys_per_block + spread);
+    double result = 0;
+    for (std::uint64_t i = lo; i <= hi; ++i) {
+        const double log_pmf = static_cast<double>(i) * std::log(keys_per_block) - keys_per_block -
+                               std::lgamma(static_cast<double>(i) + 1);
+        result += std::exp(log_pmf) * std::pow(1 - std::pow(31.0 / 32.0, static_cast<double>(i)), 8);
+    }
+    return result;
+}
+} // namespace detail
+
+/**
+ * split block bloom filter, every key sets one bit in each of the 8 words of a single 32 byte block
+ * so a lookup touches one cache line and the word checks vectorize
+ */
+template<class key_tp, class hash_type = std::hash<key_tp>>
+class bloom_filter {
+public:
+    using key_type = key_tp;
+    using size_type = std::size_t;
+
+    struct alignas(32) block {
+        std::uint32_t words[8];
+    };
+
+    static constexpr std::uint32_t salts[8] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+                                               0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+    static constexpr size_type batch_size = 16;
+
+    std::vector<block> m_blocks;
+    hash_type m_hasher{};
+
+    /**
+     * @param expected_elements number of keys the filter is sized for
+     * @param false_positive_rate target rate of false positives once expected_elements keys were added
+     */
+    explicit bloom_filter(size_type expected_elements, double false_positive_rate = 0.01, hash_type hasher = {})
+            : m_hasher{hasher} {
+        assert(0 < false_positive_rate && false_positive_rate < 1 && "invalid false positive rate");
+        const auto n = static_cast<double>(std::max<size_type>(expected_elements, 1));
+        size_type lo = 1, hi = std::max<size_type>(expected_elements, 1) * 64;
+        while (lo < hi) {
+            const size_type mid = lo + (hi - lo) / 2;
+            if (detail::split_block_false_positive_rate(n / static_cast<double>(mid)) <= false_positive_rate)
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        assert(lo <= std::numeric_limits<std::uint32_t>::max() && "bloom_filter too large");
+        m_blocks.assign(lo, block{});
+    }
+
+    void add(key_tp const &key) {
+        _add_hash(_get_hash(key));
+    }
+
+    /**
+     * @return false if key was definitely never added, true if it probably was
+     */
+    [[nodiscard]] bool maybe_contains(key_tp const &key) const {
+        return _test_hash(_get_hash(key));
+    }
+
+    template<class Iter>
+    void add_many(Iter first, Iter last) {
+        std::uint64_t hashes[batch_size];
+        while (first != last) {
+            size_type count = 0;
+            for (; count < batch_size && first != last; ++count, ++first) {
+                hashes[count] = _get_hash(*first);
+                _prefetch(hashes[count]);
+            }
+            for (size_type i = 0; i < count; ++i)
+                _add_hash(hashes[i]);
+        }
+    }
+
+    /**
+     * @brief hashes keys in batches and prefetches their blocks before testing any of them
+     * @param out receives one bool per key, as maybe_contains would return
+     * @return out after the last written result
+     */
+    template<class Iter, class OutIter>
+    OutIter maybe_contains_many(Iter first, Iter last, OutIter out) const {
+        std::uint64_t hashes[batch_size];
+        while (first != last) {
+            size_type count = 0;
+            for (; count < batch_size && first != last; ++count, ++first) {
+                hashes[count] = _get_hash(*first);
+                _prefetch(hashes[count]);
+            }
+            for (size_type i = 0; i < count; ++i)
+                *out++ = _test_hash(hashes[i]);
+        }
+        return out;
+    }
+
+    /**
+     * @brief merges other into this filter, both must have been created with the same parameters
+     */
+    bloom_filter &operator|=(bloom_filter const &other) {
+        assert(m_blocks.size() == other.m_blocks.size() && "incompatible bloom filters");
+        for (size_type i = 0; i < m_blocks.size(); ++i)
+            for (int j = 0; j < 8; ++j)
+                m_blocks[i].words[j] |= other.m_blocks[i].words[j];
+        return *this;
+    }
+
+    void clear() {
+        std::fill(m_blocks.begin(), m_blocks.end(), block{});
+    }
+
+    /**
+     * @return size of the bit array in bytes
+     */
+    [[nodiscard]] size_type memory_usage() const {
+        return m_blocks.size() * sizeof(block);
+    }
+
+    [[nodiscard]] size_type block_count() const {
+        return m_blocks.size();
+    }
+
+    /**
+     * @return expected false positive rate after n distinct keys were added
+     */
+    [[nodiscard]] double false_positive_rate(size_type n) const {
+        return detail::split_block_false_positive_rate(static_cast<double>(n) / static_cast<double>(m_blocks.size()));
+    }
+
+private:
+    [[nodiscard]] std::uint64_t _get_hash(key_tp const &key) const {
+        return detail::mix64(static_cast<std::uint64_t>(m_hasher(key)));
+    }
+
+    [[nodiscard]] size_type _block_index(std::uint64_t hash) const {
+        return static_cast<size_type>(((hash >> 32) * m_blocks.size()) >> 32);
+    }
+
+    [[nodiscard]] static block _make_mask(std::uint64_t hash) {
+        const auto h = static_cast<std::uint32_t>(hash);
+        block mask{};
+        for (int i = 0; i < 8; ++i)
+            mask.words[i] = std::uint32_t{1} << ((h * salts[i]) >> 27);
+        return mask;
+    }
+
+    void _add_hash(std::uint64_t hash) {
+        block &b = m_blocks[_block_index(hash)];
+        const block mask = _make_mask(hash);
+        for (int i = 0; i < 8; ++i)
+            b.words[i] |= mask.words[i];
+    }
+
+    [[nodiscard]] bool _test_hash(std::uint64_t hash) const {
+        block const &b = m_blocks[_block_index(hash)];
+        const block mask = _make_mask(hash);
+        bool result = true;
+        for (int i = 0; i < 8; ++i)
+            result &= (b.words[i] & mask.words[i]) == mask.words[i];
+        return result;
+    }
+
+    void _prefetch([[maybe_unused]] std::uint64_t hash) const {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(&m_blocks[_block_index(hash)]);
+#endif
+    }
+};
+
+/**
+ * wraps a hash table with a bloom filter so lookups of absent keys usually return without touching the table
+ * @note erased keys stay in the filter until rebuild_filter is called, that only costs false positives
+ */
+template<class table_type, class hash_type = std::hash<typename table_type::key_type>>
+class bloom_filtered {
+public:
+    using key_type = typename table_type::key_type;
+    using mapped_type = typename table_type::mapped_type;
+    using value_type = typename table_type::value_type;
+    using size_type = typename table_type::size_type;
+    using filter_type = bloom_filter<key_type, hash_type>;
+
+    table_type m_table;
+    filter_type m_filter;
+
+    /**
+     * @param expected_elements number of keys the filter is sized for
+     * @param false_positive_rate target rate of false positives once expected_elements keys were added
+     */
+    explicit bloom_filtered(size_type expected_elements, double false_positive_rate = 0.01, table_type table = {})
+            : m_table{std::move(table)}, m_filter{expected_elements, false_positive_rate} {
+        for (auto const &p: m_table)
+            m_filter.add(p.first);
+    }
+
+    [[nodiscard]] bool contains(key_type const &key) const {
+        return m_filter.maybe_contains(key) && m_table.contains(key);
+    }
+
+    [[nodiscard]] auto find(key_type const &key) const {
+        return m_filter.maybe_contains(key) ? m_table.find(key) : m_table.end();
+    }
+
+    [[nodiscard]] auto find(key_type const &key) {
+        return m_filter.maybe_contains(key) ? m_table.find(key) : m_table.end();
+    }
+
+    /**
+     * @param out receives one bool per key, as contains would return
+     * @return out after the last written result
+     */
+    template<class Iter, class OutIter>
+    OutIter contains_many(Iter first, Iter last, OutIter out) const {
+        bool maybe[filter_type::batch_size];
+        while (first != last) {
+            Iter batch_first = first;
+            size_type count = 0;
+            for (; count < filter_type::batch_size && first != last; ++count)
+                ++first;
+            m_filter.maybe_contains_many(batch_first, first, maybe);
+            for (size_type i = 0; i < count; ++i, ++batch_first)
+                *out++ = maybe[i] && m_table.contains(*batch_first);
+        }
+        return out;
+    }
+
+    [[nodiscard]] mapped_type &operator[](key_type const &key) {
+        m_filter.add(key);
+        return m_table[key];
+    }
+
+    template<class... Args>
+    mapped_type &emplace(key_type const &key, Args &&...args) {
+        m_filter.add(key);
+        return m_table.emplace(key, std::forward<Args>(args)...);
+    }
+
+    mapped_type &insert(value_type const &pair) {
+        m_filter.add(pair.first);
+        return m_table.insert(pair);
+    }
+
+    void erase(key_type const &key) {
+        m_table.erase(key);
+    }
+
+    /**
+     * @brief rebuilds the filter from the keys currently in the table, dropping erased keys
+     */
+    void rebuild_filter() {
+        m_filter.clear();
+        for (auto const &p: m_table)
+            m_filter.add(p.first);
+    }
+
+    [[nodiscard]] size_type size() const { return m_table.size(); }
+
+    [[nodiscard]] bool empty() const { return m_table.empty(); }
+
+    [[nodiscard]] auto begin() { return m_table.begin(); }
+
+    [[nodiscard]] auto end() { return m_table.end(); }
+
+    [[nodiscard]] auto begin() const { return m_table.begin(); }
+
+    [[nodiscard]] auto end() const { return m_table.end(); }
+
+    [[nodiscard]] table_type const &table() const { return m_table; }
+
+    [[nodiscard]] filter_type const &filter() const { return m_filter; }
+};
+} // namespace lmj
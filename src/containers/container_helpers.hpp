@@ -1,6 +1,9 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <limits>
+#include <type_traits>
 
 namespace lmj::detail {
 template<std::uint64_t n>
@@ -12,4 +15,70 @@ using required_uint_t =
                         typename std::conditional<
                                 (n <= std::numeric_limits<std::uint32_t>::max()),
                                 std::uint32_t, std::uint64_t>::type>::type>::type;
-} // namespace lmj::detail
\ No newline at end of file
+
+/**
+ * destructive interference size of the targets we care about, std::hardware_destructive_interference_size
+ * warns with gcc because it may change between compiler flags
+ */
+inline constexpr std::size_t cache_line_size = 64;
+
+/**
+ * @brief murmurhash3 finalizer, spreads the entropy of weak hashes (like the identity) over every bit
+ */
+constexpr std::uint64_t mix64(std::uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+/**
+ * slot states of the open addressing tables, with generation_type void a control word is just the state,
+ * otherwise it also records the epoch it was written in and words of older epochs read as INACTIVE,
+ * so clearing a table only has to start a new epoch
+ */
+template<class generation_type>
+struct slot_states {
+    static constexpr bool generational = !std::is_void_v<generation_type>;
+    using word_type = std::conditional_t<generational, generation_type, std::uint8_t>;
+    static_assert(std::is_unsigned_v<word_type> && !std::is_same_v<word_type, bool>, "generation type must be an unsigned integer");
+    static constexpr word_type max_epoch = std::numeric_limits<word_type>::max() >> 2;
+
+    word_type epoch = 1;
+
+    [[nodiscard]] constexpr word_type tag(word_type state) const {
+        if constexpr (generational)
+            return static_cast<word_type>(epoch << 2 | state);
+        else
+            return state;
+    }
+
+    /**
+     * @return whether the epoch wrapped around, then every control word has to be wiped
+     */
+    constexpr bool next_epoch() {
+        if (epoch == max_epoch) {
+            epoch = 1;
+            return true;
+        }
+        ++epoch;
+        return false;
+    }
+};
+
+/**
+ * storage for a T that is only constructed when needed, use std::construct_at and std::destroy_at on value
+ */
+template<class T>
+union uninitialized {
+    T value;
+
+    constexpr uninitialized() {}
+
+    constexpr ~uninitialized() requires std::is_trivially_destructible_v<T> = default;
+
+    constexpr ~uninitialized() {}
+};
+} // namespace lmj::detail
@@ -1,5 +1,22 @@
 #pragma once
 
+#include "bitset.hpp"
+#include "bloom_filter.hpp"
+#include "external_hash_table.hpp"
+#include "flat_map.hpp"
 #include "hash_table.hpp"
+#include "hopscotch_hash_table.hpp"
+#include "lru_cache.hpp"
+#include "mpmc_queue.hpp"
+#include "partitioned_hash_table.hpp"
+#include "seqlock_hash_table.hpp"
+#include "shared_hash_table.hpp"
+#include "sketches.hpp"
+#include "small_vector.hpp"
+#include "spsc_queue.hpp"
+#include "static_flat_table.hpp"
 #include "static_hash_table.hpp"
+#include "static_perfect_hash_table.hpp"
+#include "static_string.hpp"
 #include "static_vector.hpp"
+#include "string_interner.hpp"
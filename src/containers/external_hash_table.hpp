@@ -0,0 +1,305 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "hash_table.hpp"
+#include "partitioned_hash_table.hpp"
+
+namespace lmj {
+/**
+ * hash table for data sets larger than memory, keys are split into 2^bits partitions by hash,
+ * recently used partitions are kept in memory as hash_tables and the rest are spilled to one file each
+ * @note a spilled partition is an append only log of records where later records overwrite earlier ones,
+ * so all reads and writes of a partition are sequential
+ * @note partitions are loaded whole and the one in use is never spilled, so max_in_memory is only honoured
+ * while it is at least the size of the largest partition, raise bits if a partition outgrows it
+ */
+template<class key_tp, class value_tp, class hash_type = std::hash<key_tp>>
+class external_hash_table {
+    static_assert(std::is_trivially_copyable_v<key_tp> && std::is_trivially_copyable_v<value_tp>,
+                  "spilled records are written as raw bytes");
+
+public:
+    using key_type = key_tp;
+    using mapped_type = value_tp;
+    using table_type = hash_table<key_tp, value_tp, hash_type>;
+    using size_type = std::size_t;
+
+    struct record {
+        key_tp key;
+        value_tp value;
+    };
+
+    struct partition_state {
+        table_type table{};
+        bool in_memory = true;
+        size_type spilled_records{}; // may count a key more than once
+        std::uint64_t last_use{};
+    };
+
+    static constexpr size_type io_batch = 4096;
+
+    std::filesystem::path m_directory;
+    std::vector<partition_state> m_partitions;
+    unsigned m_bits{};
+    size_type m_max_in_memory{};
+    size_type m_in_memory{};
+    std::uint64_t m_clock{};
+    hash_type m_hasher{};
+
+    /**
+     * @param directory where spilled partitions are written, created if it doesn't exist
+     * @param max_in_memory number of elements kept in memory before partitions are spilled, should be larger than
+     * any single partition (about size / 2^bits elements)
+     * @param bits the table is split into 2^bits partitions
+     */
+    external_hash_table(std::filesystem::path directory, size_type max_in_memory, unsigned bits = 6, hash_type hasher = {})
+            : m_directory{std::move(directory)}, m_partitions(size_type{1} << bits), m_bits{bits},
+              m_max_in_memory{max_in_memory}, m_hasher{hasher} {
+        assert(bits < 16 && "too many partitions");
+        std::filesystem::create_directories(m_directory);
+    }
+
+    external_hash_table(external_hash_table const &) = delete;
+
+    external_hash_table &operator=(external_hash_table const &) = delete;
+
+    external_hash_table(external_hash_table &&) noexcept = default;
+
+    ~external_hash_table() {
+        std::error_code ec;
+        for (size_type p = 0; p < m_partitions.size(); ++p)
+            if (!m_partitions[p].in_memory)
+                std::filesystem::remove(_path(p), ec);
+    }
+
+    void insert(key_tp const &key, value_tp const &value) {
+        const record r{key, value};
+        insert_many(&r, &r + 1);
+    }
+
+    /**
+     * @brief inserts or overwrites every record of [first, last), grouped so every partition is written once
+     * @param first iterator to records, or anything with members key and value
+     */
+    template<class Iter>
+    void insert_many(Iter first, Iter last) {
+        std::vector<std::vector<record>> grouped(m_partitions.size());
+        for (; first != last; ++first)
+            grouped[partition_index(first->key)].push_back({first->key, first->value});
+        // in memory partitions first so spilling triggered by them can't force a reload
+        for (bool in_memory: {true, false}) {
+            for (size_type p = 0; p < m_partitions.size(); ++p) {
+                if (grouped[p].empty() || m_partitions[p].in_memory != in_memory)
+                    continue;
+                if (in_memory) {
+                    auto &table = m_partitions[p].table;
+                    m_in_memory -= table.size();
+                    for (auto const &r: grouped[p])
+                        table[r.key] = r.value;
+                    m_in_memory += table.size();
+                    m_partitions[p].last_use = ++m_clock;
+                    _enforce_limit(p);
+                } else {
+                    _append(p, grouped[p].data(), grouped[p].size());
+                }
+                grouped[p] = {};
+            }
+        }
+    }
+
+    /**
+     * @return value associated with key, loading its partition if it was spilled
+     */
+    [[nodiscard]] std::optional<value_tp> find(key_tp const &key) {
+        auto &table = _acquire(partition_index(key));
+        auto it = table.find(key);
+        if (it == table.end())
+            return std::nullopt;
+        return it->second;
+    }
+
+    [[nodiscard]] bool contains(key_tp const &key) {
+        return _acquire(partition_index(key)).contains(key);
+    }
+
+    /**
+     * @brief looks up every key of [first, last), every spilled partition is loaded at most once
+     * @param out receives one std::optional<value_tp> per key, in order
+     * @return out after the last written result
+     */
+    template<class Iter, class OutIter>
+    OutIter find_many(Iter first, Iter last, OutIter out) {
+        std::vector<key_tp> keys(first, last);
+        std::vector<std::optional<value_tp>> results(keys.size());
+        std::vector<std::vector<size_type>> grouped(m_partitions.size());
+        for (size_type i = 0; i < keys.size(); ++i)
+            grouped[partition_index(keys[i])].push_back(i);
+        // loading a spilled partition may spill one already answered, so passes go by the state on entry
+        std::vector<char> was_in_memory(m_partitions.size());
+        for (size_type p = 0; p < m_partitions.size(); ++p)
+            was_in_memory[p] = m_partitions[p].in_memory;
+        for (bool in_memory: {true, false}) {
+            for (size_type p = 0; p < m_partitions.size(); ++p) {
+                if (grouped[p].empty() || static_cast<bool>(was_in_memory[p]) != in_memory)
+                    continue;
+                auto &table = _acquire(p);
+                for (size_type i: grouped[p])
+                    if (auto it = table.find(keys[i]); it != table.end())
+                        results[i] = it->second;
+            }
+        }
+        for (auto &result: results)
+            *out++ = std::move(result);
+        return out;
+    }
+
+    /**
+     * @brief calls f with the table of every partition in turn, spilled partitions are streamed
+     * through a temporary table and stay spilled
+     */
+    template<class F>
+    void for_each_partition(F &&f) {
+        for (size_type p = 0; p < m_partitions.size(); ++p) {
+            if (m_partitions[p].in_memory) {
+                f(std::as_const(m_partitions[p].table));
+            } else {
+                table_type table = _read(p);
+                f(std::as_const(table));
+            }
+        }
+    }
+
+    /**
+     * @brief writes the least recently used partitions to disk until at most max_in_memory elements are in memory
+     */
+    void spill(size_type max_in_memory = 0) {
+        while (m_in_memory > max_in_memory) {
+            const size_type victim = _least_recently_used(m_partitions.size());
+            if (victim == m_partitions.size())
+                break;
+            _spill(victim);
+        }
+    }
+
+    [[nodiscard]] size_type partition_index(key_tp const &key) const {
+        return detail::partition_of(static_cast<std::uint64_t>(m_hasher(key)), m_bits);
+    }
+
+    [[nodiscard]] size_type partition_count() const { return m_partitions.size(); }
+
+    /**
+     * @return number of elements, keys inserted repeatedly while their partition was spilled are counted every time
+     */
+    [[nodiscard]] size_type size() const {
+        size_type result = m_in_memory;
+        for (auto const &partition: m_partitions)
+            result += partition.spilled_records;
+        return result;
+    }
+
+    [[nodiscard]] size_type in_memory_size() const { return m_in_memory; }
+
+    [[nodiscard]] bool empty() const { return size() == 0; }
+
+private:
+    [[nodiscard]] std::filesystem::path _path(size_type p) const {
+        return m_directory / ("partition_" + std::to_string(p) + ".bin");
+    }
+
+    [[nodiscard]] size_type _least_recently_used(size_type except) const {
+        size_type result = m_partitions.size();
+        for (size_type p = 0; p < m_partitions.size(); ++p)
+            if (p != except && m_partitions[p].in_memory && m_partitions[p].table.size() &&
+                (result == m_partitions.size() || m_partitions[p].last_use < m_partitions[result].last_use))
+                result = p;
+        return result;
+    }
+
+    // keep is never spilled even if it alone exceeds the limit
+    void _enforce_limit(size_type keep) {
+        while (m_in_memory > m_max_in_memory) {
+            const size_type victim = _least_recently_used(keep);
+            if (victim == m_partitions.size())
+                break;
+            _spill(victim);
+        }
+    }
+
+    table_type &_acquire(size_type p) {
+        auto &partition = m_partitions[p];
+        partition.last_use = ++m_clock;
+        if (!partition.in_memory) {
+            partition.table = _read(p);
+            partition.in_memory = true;
+            partition.spilled_records = 0;
+            m_in_memory += partition.table.size();
+            std::filesystem::remove(_path(p));
+            _enforce_limit(p);
+        }
+        return partition.table;
+    }
+
+    void _spill(size_type p) {
+        auto &partition = m_partitions[p];
+        std::vector<record> records;
+        records.reserve(partition.table.size());
+        for (auto const &[key, value]: partition.table)
+            records.push_back({key, value});
+        std::FILE *file = _open(p, "wb");
+        _write(file, records.data(), records.size());
+        std::fclose(file);
+        m_in_memory -= partition.table.size();
+        partition.spilled_records = records.size();
+        partition.table = table_type{m_hasher};
+        partition.in_memory = false;
+    }
+
+    void _append(size_type p, record const *records, size_type count) {
+        std::FILE *file = _open(p, "ab");
+        _write(file, records, count);
+        std::fclose(file);
+        m_partitions[p].spilled_records += count;
+    }
+
+    [[nodiscard]] table_type _read(size_type p) const {
+        table_type table{m_hasher};
+        std::FILE *file = _open(p, "rb");
+        std::vector<record> buffer(io_batch);
+        size_type count;
+        while ((count = std::fread(buffer.data(), sizeof(record), buffer.size(), file)) > 0)
+            for (size_type i = 0; i < count; ++i)
+                table[buffer[i].key] = buffer[i].value;
+        const bool failed = std::ferror(file);
+        std::fclose(file);
+        if (failed)
+            throw std::runtime_error("failed to read " + _path(p).string());
+        return table;
+    }
+
+    [[nodiscard]] std::FILE *_open(size_type p, char const *mode) const {
+        std::FILE *file = std::fopen(_path(p).c_str(), mode);
+        if (!file)
+            throw std::runtime_error("failed to open " + _path(p).string());
+        return file;
+    }
+
+    void _write(std::FILE *file, record const *records, size_type count) const {
+        if (std::fwrite(records, sizeof(record), count, file) != count) {
+            std::fclose(file);
+            throw std::runtime_error("failed to write spilled partition");
+        }
+    }
+};
+} // namespace lmj
@@ -0,0 +1,341 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <utility>
+
+#include "static_vector.hpp"
+
+namespace lmj {
+namespace detail {
+/**
+ * @return index of the first of the n sorted keys that isn't less than key
+ * @note the comparison is multiplied in rather than branched on, with ?: compilers emit a branch that
+ * mispredicts half the time
+ */
+template<class key_tp, class compare_type>
+constexpr std::size_t branchless_lower_bound(key_tp const *keys, std::size_t n, key_tp const &key,
+                                             compare_type const &compare) {
+    if (n == 0)
+        return 0;
+    key_tp const *base = keys;
+    while (n > 1) {
+        const std::size_t half = n / 2;
+        base += half * static_cast<std::size_t>(compare(base[half - 1], key));
+        n -= half;
+    }
+    return static_cast<std::size_t>(base - keys) + compare(*base, key);
+}
+
+/**
+ * @return how many keys of the sorted [first, last) aren't among the n sorted keys, in one merge like pass
+ * @param project maps an element of [first, last) to its key
+ */
+template<class key_tp, class Iter, class compare_type, class projection_type = std::identity>
+constexpr std::size_t count_new_sorted(key_tp const *keys, std::size_t n, Iter first, Iter last,
+                                       compare_type const &compare, projection_type const &project = {}) {
+    std::size_t added = 0, i = 0;
+    for (; first != last; ++first) {
+        auto const &key = project(*first);
+        while (i < n && compare(keys[i], key))
+            ++i;
+        added += i == n || compare(key, keys[i]);
+    }
+    return added;
+}
+} // namespace detail
+
+/**
+ * sorted set of at most _capacity keys in a static_vector, for small read mostly sets a branchless binary search
+ * over contiguous keys beats hashing
+ */
+template<class key_tp, std::size_t _capacity, class compare_type = std::less<key_tp>>
+class flat_set {
+public:
+    using key_type = key_tp;
+    using value_type = key_tp;
+    using size_type = std::size_t;
+    using const_iterator = key_tp const *;
+    using iterator = const_iterator;
+
+    static_vector<key_tp, _capacity> m_keys;
+    compare_type m_compare{};
+
+    constexpr flat_set() = default;
+
+    constexpr flat_set(std::initializer_list<key_tp> il) {
+        for (auto const &key: il)
+            insert(key);
+    }
+
+    /**
+     * @return index of the first key not less than key
+     */
+    [[nodiscard]] constexpr size_type lower_bound(key_tp const &key) const {
+        return detail::branchless_lower_bound(m_keys.data(), m_keys.size(), key, m_compare);
+    }
+
+    /**
+     * @return index of key or size()
+     */
+    [[nodiscard]] constexpr size_type index_of(key_tp const &key) const {
+        const size_type idx = lower_bound(key);
+        return idx < size() && !m_compare(key, m_keys[idx]) ? idx : size();
+    }
+
+    [[nodiscard]] constexpr bool contains(key_tp const &key) const {
+        return index_of(key) != size();
+    }
+
+    /**
+     * @return whether key was newly inserted
+     */
+    constexpr bool insert(key_tp const &key) {
+        const size_type idx = lower_bound(key);
+        if (idx < size() && !m_compare(key, m_keys[idx]))
+            return false;
+        m_keys.insert(m_keys.begin() + idx, key);
+        return true;
+    }
+
+    /**
+     * @brief merges the strictly ascending keys of [first, last) into the set in one backwards pass,
+     * keys already in the set are skipped
+     */
+    template<std::forward_iterator Iter>
+    constexpr void insert_sorted(Iter first, Iter last) {
+        assert(std::adjacent_find(first, last, [&](auto const &a, auto const &b) { return !m_compare(a, b); }) == last &&
+               "insert_sorted needs strictly ascending keys");
+        const size_type added = detail::count_new_sorted(m_keys.data(), size(), first, last, m_compare);
+        assert(size() + added <= _capacity && "out of space in flat_set");
+        size_type old_end = size(), out = size() + added;
+        m_keys.resize(out);
+        auto rfirst = std::make_reverse_iterator(last), rlast = std::make_reverse_iterator(first);
+        while (rfirst != rlast) {
+            if (old_end && !m_compare(m_keys[old_end - 1], *rfirst)) {
+                if (!m_compare(*rfirst, m_keys[old_end - 1]))
+                    ++rfirst;
+                m_keys[--out] = std::move(m_keys[--old_end]);
+            } else {
+                m_keys[--out] = *rfirst++;
+            }
+        }
+    }
+
+    /**
+     * @return whether key was in the set
+     */
+    constexpr bool erase(key_tp const &key) {
+        const size_type idx = index_of(key);
+        if (idx == size())
+            return false;
+        m_keys.erase(m_keys.begin() + idx);
+        return true;
+    }
+
+    constexpr void clear() { m_keys.clear(); }
+
+    [[nodiscard]] constexpr const_iterator begin() const { return m_keys.begin(); }
+
+    [[nodiscard]] constexpr const_iterator end() const { return m_keys.end(); }
+
+    [[nodiscard]] constexpr size_type size() const { return m_keys.size(); }
+
+    [[nodiscard]] constexpr bool empty() const { return m_keys.empty(); }
+
+    [[nodiscard]] static constexpr size_type capacity() { return _capacity; }
+
+    [[nodiscard]] constexpr bool operator==(flat_set const &other) const { return m_keys == other.m_keys; }
+};
+
+/**
+ * sorted map of at most _capacity entries with keys and values in separate static_vectors, so the branchless
+ * binary search only touches keys
+ * @note iterate with for_each or keys() and values(), which line up index by index
+ */
+template<class key_tp, class value_tp, std::size_t _capacity, class compare_type = std::less<key_tp>>
+class flat_map {
+public:
+    using key_type = key_tp;
+    using mapped_type = value_tp;
+    using size_type = std::size_t;
+
+    static_vector<key_tp, _capacity> m_keys;
+    static_vector<value_tp, _capacity> m_values;
+    compare_type m_compare{};
+
+    constexpr flat_map() = default;
+
+    constexpr flat_map(std::initializer_list<std::pair<key_tp, value_tp>> il) {
+        for (auto const &[key, value]: il)
+            insert_or_assign(key, value);
+    }
+
+    /**
+     * @return index of the first key not less than key
+     */
+    [[nodiscard]] constexpr size_type lower_bound(key_tp const &key) const {
+        return detail::branchless_lower_bound(m_keys.data(), m_keys.size(), key, m_compare);
+    }
+
+    /**
+     * @return index of key or size()
+     */
+    [[nodiscard]] constexpr size_type index_of(key_tp const &key) const {
+        const size_type idx = lower_bound(key);
+        return idx < size() && !m_compare(key, m_keys[idx]) ? idx : size();
+    }
+
+    /**
+     * @return pointer to the value of key or nullptr
+     */
+    [[nodiscard]] constexpr value_tp *find(key_tp const &key) {
+        const size_type idx = index_of(key);
+        return idx == size() ? nullptr : &m_values[idx];
+    }
+
+    [[nodiscard]] constexpr value_tp const *find(key_tp const &key) const {
+        const size_type idx = index_of(key);
+        return idx == size() ? nullptr : &m_values[idx];
+    }
+
+    [[nodiscard]] constexpr bool contains(key_tp const &key) const {
+        return index_of(key) != size();
+    }
+
+    /**
+     * @return value at key or fails
+     */
+    [[nodiscard]] constexpr value_tp const &at(key_tp const &key) const {
+        const size_type idx = index_of(key);
+        assert(idx != size() && "key not found");
+        return m_values[idx];
+    }
+
+    /**
+     * @return reference to value associated with key or default constructs value if it doesn't exist
+     */
+    constexpr value_tp &operator[](key_tp const &key) {
+        return *try_emplace(key).first;
+    }
+
+    /**
+     * @brief constructs the value of key from args unless key already exists
+     * @return pointer to the value of key and whether it was inserted
+     */
+    template<class... Args>
+    constexpr std::pair<value_tp *, bool> try_emplace(key_tp const &key, Args &&...args) {
+        const size_type idx = lower_bound(key);
+        if (idx < size() && !m_compare(key, m_keys[idx]))
+            return {&m_values[idx], false};
+        m_keys.insert(m_keys.begin() + idx, key);
+        m_values.emplace(m_values.begin() + idx, std::forward<Args>(args)...);
+        return {&m_values[idx], true};
+    }
+
+    /**
+     * @return whether key was newly inserted, otherwise its value was overwritten
+     */
+    constexpr bool insert_or_assign(key_tp const &key, value_tp const &value) {
+        auto [ptr, inserted] = try_emplace(key, value);
+        if (!inserted)
+            *ptr = value;
+        return inserted;
+    }
+
+    /**
+     * @brief merges pairs with strictly ascending keys from [first, last) into the map in one backwards pass,
+     * a key already in the map gets the new value
+     */
+    template<std::forward_iterator Iter>
+    constexpr void insert_sorted(Iter first, Iter last) {
+        assert(std::adjacent_find(first, last, [&](auto const &a, auto const &b) { return !m_compare(a.first, b.first); }) ==
+                       last && "insert_sorted needs pairs with strictly ascending keys");
+        // count the keys that are new to know where the merged entries end
+        const size_type added = detail::count_new_sorted(m_keys.data(), size(), first, last, m_compare,
+                                                         [](auto const &pair) -> auto const & { return pair.first; });
+        assert(size() + added <= _capacity && "out of space in flat_map");
+        size_type old_end = size(), out = size() + added;
+        m_keys.resize(out);
+        m_values.resize(out);
+        auto rfirst = std::make_reverse_iterator(last), rlast = std::make_reverse_iterator(first);
+        while (rfirst != rlast) {
+            auto const &[key, value] = *rfirst;
+            if (old_end && !m_compare(m_keys[old_end - 1], key)) {
+                --out, --old_end;
+                if (!m_compare(key, m_keys[old_end])) { // same key, take the new value
+                    m_keys[out] = std::move(m_keys[old_end]);
+                    m_values[out] = value;
+                    ++rfirst;
+                } else {
+                    m_keys[out] = std::move(m_keys[old_end]);
+                    m_values[out] = std::move(m_values[old_end]);
+                }
+            } else {
+                --out;
+                m_keys[out] = key;
+                m_values[out] = value;
+                ++rfirst;
+            }
+        }
+    }
+
+    /**
+     * @return whether key was in the map
+     */
+    constexpr bool erase(key_tp const &key) {
+        const size_type idx = index_of(key);
+        if (idx == size())
+            return false;
+        m_keys.erase(m_keys.begin() + idx);
+        m_values.erase(m_values.begin() + idx);
+        return true;
+    }
+
+    /**
+     * @brief calls f(key, value) for every entry in key order
+     */
+    template<class F>
+    constexpr void for_each(F &&f) const {
+        for (size_type i = 0; i < size(); ++i)
+            f(m_keys[i], m_values[i]);
+    }
+
+    constexpr void clear() {
+        m_keys.clear();
+        m_values.clear();
+    }
+
+    [[nodiscard]] constexpr static_vector<key_tp, _capacity> const &keys() const { return m_keys; }
+
+    [[nodiscard]] constexpr static_vector<value_tp, _capacity> const &values() const { return m_values; }
+
+    [[nodiscard]] constexpr size_type size() const { return m_keys.size(); }
+
+    [[nodiscard]] constexpr bool empty() const { return m_keys.empty(); }
+
+    [[nodiscard]] static constexpr size_type capacity() { return _capacity; }
+};
+
+// tests
+static_assert([] {
+    flat_set<int, 16> set = {5, 1, 3};
+    const int more[] = {2, 3, 4, 6};
+    set.insert_sorted(std::begin(more), std::end(more));
+    set.erase(6);
+    return set.size() == 5 && std::is_sorted(set.begin(), set.end()) && set.contains(4) && !set.contains(6) &&
+           set.lower_bound(3) == 2;
+}());
+static_assert([] {
+    flat_map<int, char, 16> map = {{30, 'c'}, {10, 'a'}};
+    map[20] = 'b';
+    const std::pair<int, char> more[] = {{5, 'z'}, {20, 'B'}, {40, 'd'}};
+    map.insert_sorted(std::begin(more), std::end(more));
+    return map.size() == 5 && map.at(5) == 'z' && map.at(20) == 'B' && map.at(40) == 'd' && *map.find(10) == 'a' &&
+           !map.find(15) && map.erase(30) && !map.contains(30) && std::is_sorted(map.keys().begin(), map.keys().end());
+}());
+} // namespace lmj
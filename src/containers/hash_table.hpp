@@ -1,12 +1,16 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <cstring>
 #include <functional>
 #include <limits>
+#include <new>
 #include <utility>
 
+#include "container_helpers.hpp"
+
 namespace lmj {
 namespace detail {
 template<class T>
@@ -19,13 +23,49 @@ constexpr auto next_power_of_two_inclusive(T x) {
 }
 } // namespace detail
 
-template<class key_t, class value_t, class hash_t>
+/**
+ * growth policy hash_table has always used, grows by 8x while small to rehash rarely
+ * @note a growth policy provides grow(capacity), the capacity to grow to from capacity,
+ * and a maximum load factor of max_load_numerator / max_load_denominator
+ */
+struct default_growth_policy {
+    static constexpr std::size_t max_load_numerator = 1;
+    static constexpr std::size_t max_load_denominator = 2;
+
+    static constexpr std::size_t grow(std::size_t capacity) {
+        if (capacity == 0)
+            return 1;
+        const std::size_t pow2 = detail::next_power_of_two_inclusive(capacity);
+        return pow2 < 4096 ? std::min<std::size_t>(pow2 * 8, 8192) : pow2 * 2;
+    }
+};
+
+/**
+ * doubles the capacity on every growth, wastes at most half the table after growing
+ */
+template<std::size_t numerator = 1, std::size_t denominator = 2>
+struct doubling_growth_policy {
+    static_assert(0 < numerator && numerator < denominator, "max load factor must be in (0, 1)");
+    static constexpr std::size_t max_load_numerator = numerator;
+    static constexpr std::size_t max_load_denominator = denominator;
+
+    static constexpr std::size_t grow(std::size_t capacity) {
+        return capacity ? detail::next_power_of_two_inclusive(capacity) * 2 : 8;
+    }
+};
+
+template<class key_t, class value_t, class hash_t, class policy_t, class generation_t>
 class hash_table_iterator;
 
-template<class key_t, class value_t, class hash_t>
+template<class key_t, class value_t, class hash_t, class policy_t, class generation_t>
 class hash_table_const_iterator;
 
-template<class key_tp, class value_tp, class hash_type = std::hash<key_tp>>
+/**
+ * @tparam generation_type void or an unsigned integer, if it is an integer control words are that wide and record
+ * the epoch they were written in, then clear() only starts a new epoch instead of touching every slot
+ */
+template<class key_tp, class value_tp, class hash_type = std::hash<key_tp>,
+         class growth_policy = default_growth_policy, class generation_type = void>
 class hash_table {
     enum active_enum {
         INACTIVE = 0,
@@ -34,21 +74,24 @@ class hash_table {
     };
 
 public:
+    using key_type = key_tp;
+    using mapped_type = value_tp;
     using pair_type = std::pair<const key_tp, value_tp>;
     using size_type = std::size_t;
     using value_type = pair_type;
     using reference = pair_type &;
     using const_reference = pair_type const &;
     using difference_type = std::make_signed_t<std::size_t>;
-    using bool_type = std::uint8_t;
-    using iterator = hash_table_iterator<key_tp, value_tp, hash_type>;
-    using const_iterator = hash_table_const_iterator<key_tp, value_tp, hash_type>;
+    using bool_type = typename detail::slot_states<generation_type>::word_type;
+    using iterator = hash_table_iterator<key_tp, value_tp, hash_type, growth_policy, generation_type>;
+    using const_iterator = hash_table_const_iterator<key_tp, value_tp, hash_type, growth_policy, generation_type>;
     pair_type *m_table{};
     bool_type *m_is_set{};
     size_type m_elem_count{};
     size_type m_tomb_count{};
     size_type m_capacity{};
     hash_type m_hasher{};
+    detail::slot_states<generation_type> m_states{};
 
     hash_table() = default;
 
@@ -68,17 +111,13 @@ public:
         _alloc_size(size);
     }
 
-    ~hash_table() {
-        delete[] m_is_set;
-        delete[] m_table;
-    }
+    ~hash_table() { _free(); }
 
     hash_table &operator=(hash_table &&other) noexcept {
         if ((this == &other) | (m_table == other.m_table) |
             (m_is_set == other.m_is_set))
             return *this;
-        delete[] m_table;
-        delete[] m_is_set;
+        _free();
         m_table = other.m_table;
         m_is_set = other.m_is_set;
         m_elem_count = other.m_elem_count;
@@ -86,6 +125,7 @@ public:
         if constexpr (std::is_copy_assignable_v<hash_type>)
             m_hasher = other.m_hasher;
         m_tomb_count = other.m_tomb_count;
+        m_states = other.m_states;
         other.m_is_set = nullptr;
         other.m_table = nullptr;
         other.m_elem_count = 0;
@@ -103,7 +143,7 @@ public:
         else
             clear();
         for (size_type i = 0; i < other.m_capacity; ++i) {
-            if (other.m_is_set[i] == ACTIVE) {
+            if (other._is_active(i)) {
                 _emplace_unchecked(other.m_table[i]);
             }
         }
@@ -114,12 +154,12 @@ public:
         return *this;
     }
 
-    template<class hash_t>
-    bool operator==(hash_table<key_tp, value_tp, hash_t> const &other) const {
+    template<class hash_t, class policy_t, class generation_t>
+    bool operator==(hash_table<key_tp, value_tp, hash_t, policy_t, generation_t> const &other) const {
         if (other.size() != this->size())
             return false;
         for (size_type i = 0; i < m_capacity; ++i) {
-            if (m_is_set[i] == ACTIVE && other.contains(m_table[i].first) &&
+            if (_is_active(i) && other.contains(m_table[i].first) &&
                 other.at(m_table[i].first) != m_table[i].second) {
                 return false;
             }
@@ -139,7 +179,7 @@ public:
     [[nodiscard]] value_tp const &at(key_tp const &key) const {
         assert(m_capacity && "empty hash_table");
         const size_type idx = _get_index_read(key);
-        assert(m_is_set[idx] == ACTIVE && m_table[idx].first == key &&
+        assert(_is_active(idx) && m_table[idx].first == key &&
                "key not found");
         return m_table[idx].second;
     }
@@ -152,7 +192,7 @@ public:
         if (!m_capacity || !m_elem_count)
             return emplace(key, value_tp{});
         const size_type idx = _get_index_read(key);
-        return (m_is_set[idx] == ACTIVE && m_table[idx].first == key)
+        return (_is_active(idx) && m_table[idx].first == key)
                ? m_table[idx].second
                : emplace(key, value_tp{});
     }
@@ -164,7 +204,7 @@ public:
         if (!m_elem_count)
             return false;
         const size_type idx = _get_index_read(key);
-        return m_is_set[idx] == ACTIVE && m_table[idx].first == key;
+        return _is_active(idx) && m_table[idx].first == key;
     }
 
     /**
@@ -172,6 +212,15 @@ public:
      */
     void erase(key_tp const &_key) { remove(_key); }
 
+    /**
+     * @brief removes the element it points to without probing for its key again
+     * @param it valid iterator into this table
+     */
+    void erase(const_iterator it) {
+        assert(it.m_table_ptr == this && _is_active(it.m_index) && "invalid iterator");
+        _erase_at(it.m_index);
+    }
+
     /**
      * @param key key which is removed from table
      */
@@ -179,12 +228,8 @@ public:
         if (!m_elem_count)
             return;
         const size_type idx = _get_index_read(key);
-        if (m_is_set[idx] == ACTIVE && m_table[idx].first == key) {
-            --m_elem_count;
-            ++m_tomb_count;
-            m_table[idx].~pair_type();
-            m_is_set[idx] = TOMBSTONE;
-        }
+        if (_is_active(idx) && m_table[idx].first == key)
+            _erase_at(idx);
     }
 
     [[nodiscard]] auto begin() { return iterator(this, _get_start_index()); }
@@ -219,11 +264,35 @@ public:
      */
     template<class... Args>
     value_tp &emplace(Args &&...args) {
-        if (_should_grow())
-            _grow();
+        if (_should_grow()) {
+            if (m_tomb_count > m_elem_count)
+                _purge_tombstones();
+            else
+                _grow();
+        }
         return _emplace_unchecked(std::forward<Args>(args)...);
     }
 
+    /**
+     * @brief removes every element for which pred returns true in a single pass over the table, each freed slot
+     * is closed right away by shifting the rest of its probe cluster back, so no tombstones are left behind
+     * @param pred called with a const reference to every pair in the table
+     * @return number of removed elements
+     */
+    template<class Pred>
+    size_type erase_if(Pred &&pred) {
+        return _sweep(pred);
+    }
+
+    /**
+     * @brief keeps only the elements for which pred returns true, see erase_if
+     * @return number of removed elements
+     */
+    template<class Pred>
+    size_type retain(Pred &&pred) {
+        return erase_if([&](pair_type const &p) { return !pred(p); });
+    }
+
     /**
      * @return number of elements
      */
@@ -243,18 +312,42 @@ public:
 
     /**
      * @brief remove all elements
+     * @note O(1) with a generation_type if elements are trivially destructible
      */
     void clear() {
-        for (size_type i = 0; i < m_capacity; ++i) {
-            if (m_is_set[i] == ACTIVE) {
-                m_table[i].~pair_type();
-            }
-            m_is_set[i] = INACTIVE;
-        }
+        if constexpr (!std::is_trivially_destructible_v<pair_type>)
+            for (size_type i = 0; m_elem_count && i < m_capacity; ++i)
+                if (_is_active(i))
+                    m_table[i].~pair_type();
+        if (!m_states.generational || m_states.next_epoch())
+            std::fill(m_is_set, m_is_set + m_capacity, bool_type{});
         m_elem_count = 0;
         m_tomb_count = 0;
     }
 
+    /**
+     * @brief allocates enough capacity that inserting up to n elements in total won't grow the table
+     */
+    void reserve(size_type n) {
+        const size_type new_capacity = _capacity_for(n);
+        if (new_capacity > m_capacity || (m_tomb_count && _capacity_for(n + m_tomb_count) > m_capacity))
+            _set_size(std::max(new_capacity, m_capacity));
+    }
+
+    /**
+     * @brief reallocates the table to the smallest capacity the growth policy allows for the current
+     * elements, dropping all tombstones, frees everything if the table is empty
+     */
+    void shrink_to_fit() {
+        if (!m_elem_count) {
+            _free();
+            return;
+        }
+        const size_type new_capacity = _capacity_for(m_elem_count);
+        if (new_capacity < m_capacity || m_tomb_count)
+            _set_size(std::min(new_capacity, m_capacity));
+    }
+
     /**
      * @brief resizes the table and causes a rehash of all elements
      * fails if new_capacity is less than current number of elements
@@ -264,7 +357,7 @@ public:
         assert(new_capacity >= m_elem_count);
         hash_table other{new_capacity, m_hasher};
         for (size_type i = 0; i < m_capacity; ++i) {
-            if (m_is_set[i] == ACTIVE)
+            if (_is_active(i))
                 other.emplace(std::move(m_table[i].first),
                               std::move(m_table[i].second));
         }
@@ -275,7 +368,7 @@ public:
         if (!m_elem_count)
             return end();
         const size_type idx = _get_index_read(key);
-        if (m_is_set[idx] == ACTIVE && m_table[idx].first == key)
+        if (_is_active(idx) && m_table[idx].first == key)
             return const_iterator(this, idx);
         return end();
     }
@@ -284,11 +377,37 @@ public:
         if (!m_elem_count)
             return end();
         const size_type idx = _get_index_read(key);
-        if (m_is_set[idx] == ACTIVE && m_table[idx].first == key)
+        if (_is_active(idx) && m_table[idx].first == key)
             return iterator(this, idx);
         return end();
     }
 
+    [[nodiscard]] bool _is_active(size_type idx) const { return m_is_set[idx] == m_states.tag(ACTIVE); }
+
+    [[nodiscard]] bool _is_tombstone(size_type idx) const { return m_is_set[idx] == m_states.tag(TOMBSTONE); }
+
+    [[nodiscard]] bool _is_inactive(size_type idx) const { return !_is_active(idx) && !_is_tombstone(idx); }
+
+    void _set_state(size_type idx, active_enum state) { m_is_set[idx] = m_states.tag(state); }
+
+    /**
+     * @brief destroys the active element at idx and leaves a tombstone
+     */
+    void _erase_at(size_type idx) {
+        --m_elem_count;
+        ++m_tomb_count;
+        m_table[idx].~pair_type();
+        _set_state(idx, TOMBSTONE);
+    }
+
+    /**
+     * @return whether the next emplace of a new key grows the table, to growth_policy::grow(capacity())
+     */
+    [[nodiscard]] bool _should_grow() const {
+        return !m_capacity || (m_elem_count + m_tomb_count) * growth_policy::max_load_denominator >
+                              m_capacity * growth_policy::max_load_numerator;
+    }
+
     [[nodiscard]] size_type _clamp_size(size_type idx) const {
         if (m_capacity & (m_capacity - 1)) [[unlikely]]
             return idx % m_capacity;
@@ -301,19 +420,88 @@ public:
      * @note don't use this without reading the implementation
      */
     void _set_size(size_type new_size) {
-        hash_table other;
+        hash_table other{m_hasher};
         other._alloc_size(new_size);
         for (size_type i = 0; i < m_capacity; ++i) {
-            if (m_is_set[i] == ACTIVE) {
+            if (_is_active(i)) {
                 const size_type idx = other._get_writable_index(m_table[i].first);
                 new(&other.m_table[idx]) pair_type{std::move(m_table[i].first),
                                                    std::move(m_table[i].second)};
-                other.m_is_set[idx] = ACTIVE;
+                other._set_state(idx, ACTIVE);
             }
         }
+        other.m_elem_count = m_elem_count;
         *this = std::move(other);
     }
 
+    /**
+     * @brief turns every tombstone back into an empty slot without allocating
+     */
+    void _purge_tombstones() {
+        if (m_tomb_count)
+            _sweep([](pair_type const &) { return false; });
+    }
+
+    /**
+     * @brief walks the slots once, starting after an empty one, removes the elements pred matches and closes
+     * every freed slot and tombstone with _close_hole
+     * @return number of removed elements
+     * @note only keys in the probe clusters that had a freed slot are rehashed
+     */
+    template<class Pred>
+    size_type _sweep(Pred &&pred) {
+        const size_type old_count = m_elem_count;
+        size_type start = 0;
+        while (start < m_capacity && !_is_inactive(start))
+            ++start;
+        if (start == m_capacity) { // no probe cluster is guaranteed to end anywhere, rebuild instead
+            for (size_type i = 0; i < m_capacity; ++i) {
+                if (_is_active(i) && pred(std::as_const(m_table[i]))) {
+                    m_table[i].~pair_type();
+                    _set_state(i, TOMBSTONE);
+                    --m_elem_count;
+                }
+            }
+            if (m_capacity)
+                _set_size(m_capacity);
+            return old_count - m_elem_count;
+        }
+        // clusters never wrap past the empty slot at start, so everything _close_hole shifts back comes from
+        // slots the sweep hasn't reached yet, and slot i is looked at again after it was refilled
+        for (size_type i = _new_idx(start); i != start;) {
+            if (_is_tombstone(i)) {
+                --m_tomb_count;
+                _close_hole(i);
+            } else if (_is_active(i) && pred(std::as_const(m_table[i]))) {
+                m_table[i].~pair_type();
+                --m_elem_count;
+                _close_hole(i);
+            } else {
+                i = _new_idx(i);
+            }
+        }
+        return old_count - m_elem_count;
+    }
+
+    /**
+     * @brief backward shift deletion, every later element of the probe cluster whose probe passes the free slot
+     * hole moves into it and leaves a new hole behind, the last hole becomes empty
+     */
+    void _close_hole(size_type hole) {
+        for (size_type i = _new_idx(hole); !_is_inactive(i); i = _new_idx(i)) {
+            if (!_is_active(i))
+                continue;
+            const size_type home = _get_hash(m_table[i].first);
+            if (_clamp_size(i + m_capacity - home) >= _clamp_size(i + m_capacity - hole)) {
+                new(m_table + hole) pair_type{std::move(m_table[i])};
+                m_table[i].~pair_type();
+                _set_state(hole, ACTIVE);
+                hole = i;
+            }
+        }
+        _set_state(hole, INACTIVE);
+    }
+
     [[nodiscard]] bool empty() const { return m_elem_count == 0; }
 
 private:
@@ -323,23 +511,23 @@ private:
         auto p = pair_type{std::forward<Args>(args)...};
         const size_type hash = _get_hash(p.first);
         const size_type read_idx = _get_index_read(p.first, hash);
-        if (m_is_set[read_idx] == ACTIVE && m_table[read_idx].first == p.first)
+        if (_is_active(read_idx) && m_table[read_idx].first == p.first)
             return m_table[read_idx].second;
         const size_type write_idx = _get_writable_index(p.first, hash);
         ++m_elem_count;
-        m_tomb_count -= m_is_set[write_idx] == TOMBSTONE;
-        m_is_set[write_idx] = ACTIVE;
+        m_tomb_count -= _is_tombstone(write_idx);
+        _set_state(write_idx, ACTIVE);
         new(m_table + write_idx) pair_type{std::move(p)};
         return m_table[write_idx].second;
     }
 
     [[nodiscard]] size_type _get_start_index() const {
-        if (!m_capacity)
-            return 0;
+        if (!m_elem_count)
+            return _get_end_index();
         for (size_type i = 0; i < m_capacity; ++i)
-            if (m_is_set[i] == ACTIVE)
+            if (_is_active(i))
                 return i;
-        return 0; // should be unreachable;
+        return _get_end_index(); // should be unreachable;
     }
 
     [[nodiscard]] size_type _get_end_index() const { return m_capacity; }
@@ -367,8 +555,8 @@ private:
     [[nodiscard]] size_type _get_index_read_impl(key_tp const &key,
                                                  size_type idx) const {
         [[maybe_unused]] std::size_t iterations = 0;
-        while ((m_is_set[idx] == TOMBSTONE ||
-                (m_is_set[idx] == ACTIVE && m_table[idx].first != key)) &&
+        while ((_is_tombstone(idx) ||
+                (_is_active(idx) && m_table[idx].first != key)) &&
                iterations++ < m_capacity) {
             idx = _new_idx(idx);
         }
@@ -387,48 +575,68 @@ private:
     [[nodiscard]] size_type _get_writable_index_impl(key_tp const &key,
                                                      size_type idx) const {
         [[maybe_unused]] std::size_t iterations = 0;
-        while (m_is_set[idx] == ACTIVE && m_table[idx].first != key) {
+        while (_is_active(idx) && m_table[idx].first != key) {
             assert(iterations++ < m_capacity && "element not found");
             idx = _new_idx(idx);
         }
         return idx;
     }
 
-    [[nodiscard]] bool _should_grow() const {
-        return !m_capacity || (m_elem_count + m_tomb_count) * 2 > m_capacity;
+    /**
+     * @return smallest power of two capacity that holds n elements without growing
+     */
+    [[nodiscard]] static size_type _capacity_for(size_type n) {
+        if (!n)
+            return 0;
+        return detail::next_power_of_two_inclusive(
+                (n * growth_policy::max_load_denominator + growth_policy::max_load_numerator - 1) /
+                growth_policy::max_load_numerator);
     }
 
     void _grow() {
-        constexpr auto default_size = 1;
-        if (m_capacity == 0) {
-            resize(default_size);
-        } else {
-            const size_type pow2 = detail::next_power_of_two_inclusive(m_capacity);
-            const size_type new_capacity =
-                    pow2 < 4096 ? std::min<size_type>(pow2 * 8, 8192) : pow2 * 2;
-            resize(new_capacity);
-        }
+        resize(growth_policy::grow(m_capacity));
     }
 
-    void _alloc_size(size_type new_capacity) {
+    // slots are raw storage, only ACTIVE slots hold constructed pairs
+    static pair_type *_allocate(size_type n) {
+        return static_cast<pair_type *>(::operator new(n * sizeof(pair_type), std::align_val_t{alignof(pair_type)}));
+    }
+
+    void _free() {
+        if constexpr (!std::is_trivially_destructible_v<pair_type>)
+            for (size_type i = 0; i < m_capacity; ++i)
+                if (_is_active(i))
+                    m_table[i].~pair_type();
         delete[] m_is_set;
-        delete[] m_table;
-        m_is_set = new bool_type[new_capacity]{};
-        m_table = new pair_type[new_capacity];
+        ::operator delete(m_table, std::align_val_t{alignof(pair_type)});
+        m_is_set = nullptr;
+        m_table = nullptr;
         m_elem_count = 0;
         m_tomb_count = 0;
+        m_capacity = 0;
+    }
+
+    void _alloc_size(size_type new_capacity) {
+        _free();
+        m_is_set = new bool_type[new_capacity]{};
+        m_table = _allocate(new_capacity);
         m_capacity = new_capacity;
     }
 };
 
-template<class key_t, class value_t, class hash_t = std::hash<key_t>>
-class hash_table_iterator {
-    enum active_enum {
-        INACTIVE = 0,
-        ACTIVE = 1,
-        TOMBSTONE = 2,
-    };
+/**
+ * @brief removes every element of table for which pred returns true
+ * @return number of removed elements
+ */
+template<class key_t, class value_t, class hash_t, class policy_t, class generation_t, class Pred>
+typename hash_table<key_t, value_t, hash_t, policy_t, generation_t>::size_type
+erase_if(hash_table<key_t, value_t, hash_t, policy_t, generation_t> &table, Pred &&pred) {
+    return table.erase_if(std::forward<Pred>(pred));
+}
 
+template<class key_t, class value_t, class hash_t = std::hash<key_t>, class policy_t = default_growth_policy,
+         class generation_t = void>
+class hash_table_iterator {
 public:
     using pair_type = std::pair<key_t const, value_t>;
     using size_type = std::size_t;
@@ -439,7 +647,7 @@ public:
     using pointer = pair_type *;
     using reference = pair_type &;
 
-    hash_table<key_t, value_t, hash_t> *m_table_ptr = nullptr;
+    hash_table<key_t, value_t, hash_t, policy_t, generation_t> *m_table_ptr = nullptr;
     size_type m_index = 0;
 
     hash_table_iterator() = default;
@@ -448,14 +656,14 @@ public:
 
     hash_table_iterator &operator=(hash_table_iterator const &) = default;
 
-    hash_table_iterator(hash_table<key_t, value_t, hash_t> *ptr, size_type idx)
+    hash_table_iterator(hash_table<key_t, value_t, hash_t, policy_t, generation_t> *ptr, size_type idx)
             : m_table_ptr{ptr}, m_index{idx} {}
 
     hash_table_iterator &operator++() {
         do {
             ++m_index;
         } while (m_index < m_table_ptr->capacity() &&
-                 m_table_ptr->m_is_set[m_index] != ACTIVE);
+                 !m_table_ptr->_is_active(m_index));
         return *this;
     }
 
@@ -468,7 +676,7 @@ public:
     hash_table_iterator &operator--() {
         do {
             --m_index;
-        } while (m_index > 0 && m_table_ptr->m_is_set[m_index] != ACTIVE);
+        } while (m_index > 0 && !m_table_ptr->_is_active(m_index));
         return *this;
     }
 
@@ -493,14 +701,9 @@ public:
     }
 };
 
-template<class key_t, class value_t, class hash_t = std::hash<key_t>>
+template<class key_t, class value_t, class hash_t = std::hash<key_t>, class policy_t = default_growth_policy,
+         class generation_t = void>
 class hash_table_const_iterator {
-    enum active_enum {
-        INACTIVE = 0,
-        ACTIVE = 1,
-        TOMBSTONE = 2,
-    };
-
 public:
     using pair_type = std::pair<key_t const, value_t>;
     using size_type = std::size_t;
@@ -511,7 +714,7 @@ public:
     using pointer = pair_type const *;
     using reference = pair_type const &;
 
-    hash_table<key_t, value_t, hash_t> const *m_table_ptr = nullptr;
+    hash_table<key_t, value_t, hash_t, policy_t, generation_t> const *m_table_ptr = nullptr;
     size_type m_index = 0;
 
     hash_table_const_iterator() = default;
@@ -521,18 +724,18 @@ public:
     hash_table_const_iterator &
     operator=(hash_table_const_iterator const &) = default;
 
-    hash_table_const_iterator(hash_table<key_t, value_t, hash_t> const *ptr,
+    hash_table_const_iterator(hash_table<key_t, value_t, hash_t, policy_t, generation_t> const *ptr,
                               size_type idx)
             : m_table_ptr{ptr}, m_index{idx} {}
 
     hash_table_const_iterator(
-            hash_table_iterator<key_t, value_t, hash_t> const &other)
+            hash_table_iterator<key_t, value_t, hash_t, policy_t, generation_t> const &other)
             : m_table_ptr{other.m_table_ptr}, m_index{other.m_index} {}
 
     hash_table_const_iterator &operator++() {
         ++m_index;
         while (m_index < m_table_ptr->capacity() &&
-               m_table_ptr->m_is_set[m_index] != ACTIVE)
+               !m_table_ptr->_is_active(m_index))
             ++m_index;
         return *this;
     }
@@ -545,7 +748,7 @@ public:
 
     hash_table_const_iterator &operator--() {
         --m_index;
-        while (m_index > 0 && m_table_ptr->m_is_set[m_index] != ACTIVE)
+        while (m_index > 0 && !m_table_ptr->_is_active(m_index))
             --m_index;
         return *this;
     }
@@ -0,0 +1,278 @@
+#pragma once
+
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "container_helpers.hpp"
+#include "static_hash_table.hpp"
+
+namespace lmj {
+/**
+ * fixed capacity hopscotch hash table, every key is stored within _neighborhood slots of its home bucket
+ * and each bucket has a bitmap of which slots of its neighborhood hold its keys, so a lookup compares at most
+ * _neighborhood keys no matter the load or how many keys were erased
+ * @note keys and values are stored in separate arrays so a lookup only touches the hop word, one or two
+ * cache lines of keys and the found value
+ * @note an insertion fails (try_emplace returns nullptr) if no free slot can be moved into the neighborhood,
+ * with a neighborhood of 32 that starts happening at ~93% load when only inserting, and above ~75% load
+ * under sustained erase/insert churn, a neighborhood of 64 holds up to ~85% under churn
+ */
+template<class key_tp, class value_tp, std::size_t _capacity, std::size_t _neighborhood = 32,
+         class hash_type = lmj::hash<key_tp>>
+class static_hopscotch_table {
+    static_assert(_capacity && "a table with a capacity of zero is not allowed");
+    static_assert(0 < _neighborhood && _neighborhood <= 64 && _neighborhood <= _capacity, "unsupported neighborhood");
+
+public:
+    using key_type = key_tp;
+    using mapped_type = value_tp;
+    using size_type = std::size_t;
+    using hop_type = detail::required_uint_t<(std::uint64_t{1} << (_neighborhood - 1))>;
+
+    hop_type m_hops[_capacity]{};
+    bool m_occupied[_capacity]{};
+    detail::uninitialized<key_tp> m_keys[_capacity];
+    detail::uninitialized<value_tp> m_values[_capacity];
+    size_type m_elem_count{};
+    hash_type m_hasher{};
+
+    constexpr static_hopscotch_table() = default;
+
+    constexpr explicit static_hopscotch_table(hash_type hasher) : m_hasher{hasher} {}
+
+    constexpr static_hopscotch_table(static_hopscotch_table const &other) { *this = other; }
+
+    constexpr static_hopscotch_table(static_hopscotch_table &&other) noexcept { *this = std::move(other); }
+
+    constexpr ~static_hopscotch_table()
+        requires(std::is_trivially_destructible_v<key_tp> && std::is_trivially_destructible_v<value_tp>) = default;
+
+    constexpr ~static_hopscotch_table() { clear(); }
+
+    constexpr static_hopscotch_table &operator=(static_hopscotch_table const &other) {
+        if (this != &other)
+            _copy(other);
+        return *this;
+    }
+
+    constexpr static_hopscotch_table &operator=(static_hopscotch_table &&other) noexcept {
+        if (this != &other)
+            _copy(std::move(other));
+        return *this;
+    }
+
+    /**
+     * @return pointer to the value of key or nullptr
+     */
+    [[nodiscard]] constexpr value_tp *find(key_tp const &key) {
+        const size_type idx = _find_index(key);
+        return idx == _capacity ? nullptr : &m_values[idx].value;
+    }
+
+    [[nodiscard]] constexpr value_tp const *find(key_tp const &key) const {
+        const size_type idx = _find_index(key);
+        return idx == _capacity ? nullptr : &m_values[idx].value;
+    }
+
+    [[nodiscard]] constexpr bool contains(key_tp const &key) const {
+        return _find_index(key) != _capacity;
+    }
+
+    /**
+     * @return value at key or fails
+     */
+    [[nodiscard]] constexpr value_tp const &at(key_tp const &key) const {
+        const size_type idx = _find_index(key);
+        assert(idx != _capacity && "key not found");
+        return m_values[idx].value;
+    }
+
+    /**
+     * @return reference to value associated with key or default constructs value if it doesn't exist
+     */
+    constexpr value_tp &operator[](key_tp const &key) {
+        value_tp *value = try_emplace(key);
+        assert(value && "static_hopscotch_table neighborhood full");
+        return *value;
+    }
+
+    /**
+     * @brief constructs the value of key from args unless key already exists
+     * @return pointer to the value of key, nullptr if there was no room for it
+     */
+    template<class... Args>
+    constexpr value_tp *try_emplace(key_tp const &key, Args &&...args) {
+        const size_type home = _get_hash(key);
+        if (const size_type idx = _find_index(key, home); idx != _capacity)
+            return &m_values[idx].value;
+        size_type distance = 0;
+        while (distance < _capacity && m_occupied[_wrap(home + distance)])
+            ++distance;
+        if (distance == _capacity)
+            return nullptr;
+        // hop the free slot backwards until it lies within the neighborhood of home
+        while (distance >= _neighborhood) {
+            const size_type moved = _move_closer(_wrap(home + distance));
+            if (moved == 0)
+                return nullptr;
+            distance -= moved;
+        }
+        const size_type idx = _wrap(home + distance);
+        std::construct_at(&m_keys[idx].value, key);
+        std::construct_at(&m_values[idx].value, std::forward<Args>(args)...);
+        m_occupied[idx] = true;
+        m_hops[home] |= static_cast<hop_type>(hop_type{1} << distance);
+        ++m_elem_count;
+        return &m_values[idx].value;
+    }
+
+    /**
+     * @return whether key was newly inserted, false if it existed or there was no room
+     */
+    constexpr bool insert(key_tp const &key, value_tp const &value) {
+        const size_type old_count = m_elem_count;
+        try_emplace(key, value);
+        return m_elem_count != old_count;
+    }
+
+    /**
+     * @return whether key was in the table
+     */
+    constexpr bool erase(key_tp const &key) {
+        const size_type home = _get_hash(key);
+        const size_type idx = _find_index(key, home);
+        if (idx == _capacity)
+            return false;
+        std::destroy_at(&m_keys[idx].value);
+        std::destroy_at(&m_values[idx].value);
+        m_occupied[idx] = false;
+        m_hops[home] &= static_cast<hop_type>(~(hop_type{1} << _distance(home, idx)));
+        --m_elem_count;
+        return true;
+    }
+
+    /**
+     * @brief calls f(key, value) for every element
+     */
+    template<class F>
+    constexpr void for_each(F &&f) const {
+        for (size_type i = 0; i < _capacity; ++i)
+            if (m_occupied[i])
+                f(m_keys[i].value, m_values[i].value);
+    }
+
+    constexpr void clear() {
+        for (size_type i = 0; i < _capacity; ++i) {
+            if (m_occupied[i]) {
+                std::destroy_at(&m_keys[i].value);
+                std::destroy_at(&m_values[i].value);
+                m_occupied[i] = false;
+            }
+            m_hops[i] = 0;
+        }
+        m_elem_count = 0;
+    }
+
+    [[nodiscard]] constexpr size_type size() const { return m_elem_count; }
+
+    [[nodiscard]] constexpr bool empty() const { return m_elem_count == 0; }
+
+    [[nodiscard]] static constexpr size_type capacity() { return _capacity; }
+
+    [[nodiscard]] static constexpr size_type neighborhood() { return _neighborhood; }
+
+private:
+    [[nodiscard]] static constexpr size_type _wrap(size_type idx) {
+        if constexpr (_capacity & (_capacity - 1))
+            return idx % _capacity;
+        else
+            return idx & (_capacity - 1);
+    }
+
+    [[nodiscard]] static constexpr size_type _distance(size_type from, size_type to) {
+        return to >= from ? to - from : to + _capacity - from;
+    }
+
+    [[nodiscard]] constexpr size_type _get_hash(key_tp const &key) const {
+        return _wrap(static_cast<size_type>(detail::mix64(static_cast<std::uint64_t>(m_hasher(key)))));
+    }
+
+    [[nodiscard]] constexpr size_type _find_index(key_tp const &key) const {
+        return _find_index(key, _get_hash(key));
+    }
+
+    [[nodiscard]] constexpr size_type _find_index(key_tp const &key, size_type home) const {
+        for (hop_type hops = m_hops[home]; hops; hops &= static_cast<hop_type>(hops - 1)) {
+            const size_type idx = _wrap(home + static_cast<size_type>(std::countr_zero(hops)));
+            if (m_keys[idx].value == key)
+                return idx;
+        }
+        return _capacity;
+    }
+
+    /**
+     * @brief moves an element from before the free slot into it, keeping it in its own neighborhood
+     * @return how far the free slot moved backwards, 0 if no element could be moved
+     */
+    constexpr size_type _move_closer(size_type free) {
+        for (size_type back = _neighborhood - 1; back > 0; --back) {
+            const size_type bucket = _wrap(free + _capacity - back);
+            // the earliest element of bucket that lies before free
+            const hop_type candidates = m_hops[bucket] & static_cast<hop_type>((hop_type{1} << back) - 1);
+            if (!candidates)
+                continue;
+            const auto offset = static_cast<size_type>(std::countr_zero(candidates));
+            const size_type from = _wrap(bucket + offset);
+            std::construct_at(&m_keys[free].value, std::move(m_keys[from].value));
+            std::construct_at(&m_values[free].value, std::move(m_values[from].value));
+            std::destroy_at(&m_keys[from].value);
+            std::destroy_at(&m_values[from].value);
+            m_occupied[free] = true;
+            m_occupied[from] = false;
+            m_hops[bucket] = static_cast<hop_type>((m_hops[bucket] & ~(hop_type{1} << offset)) | (hop_type{1} << back));
+            return back - offset;
+        }
+        return 0;
+    }
+
+    template<class table_type>
+    constexpr void _copy(table_type &&other) {
+        clear();
+        for (size_type i = 0; i < _capacity; ++i) {
+            if (other.m_occupied[i]) {
+                if constexpr (std::is_rvalue_reference_v<table_type &&>) {
+                    std::construct_at(&m_keys[i].value, std::move(other.m_keys[i].value));
+                    std::construct_at(&m_values[i].value, std::move(other.m_values[i].value));
+                } else {
+                    std::construct_at(&m_keys[i].value, other.m_keys[i].value);
+                    std::construct_at(&m_values[i].value, other.m_values[i].value);
+                }
+                m_occupied[i] = true;
+            }
+            m_hops[i] = other.m_hops[i];
+        }
+        m_elem_count = other.m_elem_count;
+        if constexpr (std::is_copy_assignable_v<hash_type>)
+            m_hasher = other.m_hasher;
+    }
+};
+
+// tests
+static_assert([] {
+    static_hopscotch_table<int, int, 64, 8> table;
+    for (int i = 0; i < 56; ++i)
+        if (!table.insert(i * 3, i))
+            return false;
+    for (int i = 0; i < 56; i += 2)
+        table.erase(i * 3);
+    auto copy = table;
+    for (int i = 0; i < 56; ++i)
+        if (copy.contains(i * 3) != (i % 2 == 1) || (i % 2 && copy.at(i * 3) != i))
+            return false;
+    return copy.size() == 28;
+}());
+} // namespace lmj
@@ -0,0 +1,436 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "hash_table.hpp"
+
+namespace lmj {
+namespace detail {
+struct no_eviction_callback {
+    template<class K, class V>
+    constexpr void operator()(K const &, V &) const {}
+};
+
+/**
+ * @return capacity of an index which holds n keys without ever growing, tombstones are purged in place instead
+ */
+constexpr std::size_t cache_index_capacity(std::size_t n) {
+    return next_power_of_two_inclusive(n * 4);
+}
+} // namespace detail
+
+/**
+ * fixed capacity cache which evicts the least recently used entry
+ * @note all memory is allocated on construction, entries are constructed on insert and destroyed on erase/eviction
+ */
+template<class key_tp, class value_tp, class hash_type = std::hash<key_tp>,
+         class evict_type = detail::no_eviction_callback>
+class lru_cache {
+public:
+    using size_type = std::size_t;
+    using index_type = std::uint32_t;
+    static constexpr index_type npos = std::numeric_limits<index_type>::max();
+
+    struct node {
+        detail::uninitialized<key_tp> key;
+        detail::uninitialized<value_tp> value;
+        index_type prev = npos;
+        index_type next = npos;
+    };
+
+    std::vector<node> m_nodes;
+    hash_table<key_tp, index_type, hash_type> m_index;
+    evict_type m_on_evict{};
+    index_type m_head = npos; // most recently used
+    index_type m_tail = npos; // least recently used
+    index_type m_free = npos; // unused nodes, linked through next
+    size_type m_size{};
+    size_type m_hits{};
+    size_type m_misses{};
+    size_type m_evictions{};
+
+    /**
+     * @param capacity maximum number of entries
+     * @param on_evict called with key and value of every entry evicted to make room for a new one
+     */
+    explicit lru_cache(size_type capacity, evict_type on_evict = {}, hash_type hasher = {})
+            : m_nodes(capacity), m_index(detail::cache_index_capacity(capacity), hasher), m_on_evict{std::move(on_evict)} {
+        assert(capacity && capacity < npos && "invalid capacity");
+        _reset_free_list();
+    }
+
+    lru_cache(lru_cache &&other) noexcept
+            : m_nodes{std::move(other.m_nodes)}, m_index{std::move(other.m_index)},
+              m_on_evict{std::move(other.m_on_evict)}, m_head{std::exchange(other.m_head, npos)},
+              m_tail{std::exchange(other.m_tail, npos)}, m_free{std::exchange(other.m_free, npos)},
+              m_size{std::exchange(other.m_size, 0)}, m_hits{other.m_hits}, m_misses{other.m_misses},
+              m_evictions{other.m_evictions} {}
+
+    lru_cache(lru_cache const &) = delete;
+
+    lru_cache &operator=(lru_cache const &) = delete;
+
+    ~lru_cache() {
+        _destroy_entries();
+    }
+
+    /**
+     * @brief looks up key and marks it as most recently used
+     * @return pointer to value associated with key or nullptr if it isn't cached
+     */
+    [[nodiscard]] value_tp *find(key_tp const &key) {
+        const auto it = m_index.find(key);
+        if (it == m_index.end()) {
+            ++m_misses;
+            return nullptr;
+        }
+        ++m_hits;
+        const index_type idx = it->second;
+        _unlink(idx);
+        _push_front(idx);
+        return &m_nodes[idx].value.value;
+    }
+
+    /**
+     * @brief looks up key without touching recency or hit/miss counters
+     * @return pointer to value associated with key or nullptr if it isn't cached
+     */
+    [[nodiscard]] value_tp const *peek(key_tp const &key) const {
+        const auto it = m_index.find(key);
+        return it == m_index.end() ? nullptr : &m_nodes[it->second].value.value;
+    }
+
+    /**
+     * @return whether key is cached
+     */
+    [[nodiscard]] bool contains(key_tp const &key) const {
+        return m_index.contains(key);
+    }
+
+    /**
+     * @brief inserts or overwrites value at key, evicting the least recently used entry if full
+     * @return reference to value in cache
+     */
+    value_tp &insert(key_tp const &key, value_tp value) {
+        const auto it = m_index.find(key);
+        if (it != m_index.end()) {
+            const index_type idx = it->second;
+            m_nodes[idx].value.value = std::move(value);
+            _unlink(idx);
+            _push_front(idx);
+            return m_nodes[idx].value.value;
+        }
+        if (m_free == npos)
+            _evict();
+        const index_type idx = m_free;
+        m_free = m_nodes[idx].next;
+        std::construct_at(&m_nodes[idx].key.value, key);
+        std::construct_at(&m_nodes[idx].value.value, std::move(value));
+        _push_front(idx);
+        m_index.emplace(key, idx);
+        ++m_size;
+        return m_nodes[idx].value.value;
+    }
+
+    /**
+     * @brief removes key from cache without calling the eviction callback
+     * @return whether key was cached
+     */
+    bool erase(key_tp const &key) {
+        const auto it = m_index.find(key);
+        if (it == m_index.end())
+            return false;
+        const index_type idx = it->second;
+        m_index.erase(it);
+        _release(idx);
+        return true;
+    }
+
+    /**
+     * @brief remove all entries without calling the eviction callback, counters are kept
+     */
+    void clear() {
+        _destroy_entries();
+        m_index.clear();
+        m_head = m_tail = npos;
+        m_size = 0;
+        _reset_free_list();
+    }
+
+    void reset_stats() {
+        m_hits = m_misses = m_evictions = 0;
+    }
+
+    [[nodiscard]] size_type size() const { return m_size; }
+
+    [[nodiscard]] size_type capacity() const { return m_nodes.size(); }
+
+    [[nodiscard]] bool empty() const { return m_size == 0; }
+
+    [[nodiscard]] size_type hits() const { return m_hits; }
+
+    [[nodiscard]] size_type misses() const { return m_misses; }
+
+    [[nodiscard]] size_type evictions() const { return m_evictions; }
+
+private:
+    void _reset_free_list() {
+        for (index_type i = 0; i < m_nodes.size(); ++i)
+            m_nodes[i].next = i + 1 < m_nodes.size() ? i + 1 : npos;
+        m_free = 0;
+    }
+
+    void _evict() {
+        const index_type idx = m_tail;
+        assert(idx != npos);
+        m_on_evict(std::as_const(m_nodes[idx].key.value), m_nodes[idx].value.value);
+        m_index.erase(m_nodes[idx].key.value);
+        _release(idx);
+        ++m_evictions;
+    }
+
+    /**
+     * @brief destroys the entry at idx, which is already out of the index, and returns its node to the free list
+     */
+    void _release(index_type idx) {
+        _unlink(idx);
+        std::destroy_at(&m_nodes[idx].key.value);
+        std::destroy_at(&m_nodes[idx].value.value);
+        m_nodes[idx].next = m_free;
+        m_free = idx;
+        --m_size;
+    }
+
+    // leaves the list dangling, callers reset it
+    void _destroy_entries() {
+        for (index_type idx = m_head; idx != npos; idx = m_nodes[idx].next) {
+            std::destroy_at(&m_nodes[idx].key.value);
+            std::destroy_at(&m_nodes[idx].value.value);
+        }
+    }
+
+    void _unlink(index_type idx) {
+        node &n = m_nodes[idx];
+        if (n.prev != npos)
+            m_nodes[n.prev].next = n.next;
+        else
+            m_head = n.next;
+        if (n.next != npos)
+            m_nodes[n.next].prev = n.prev;
+        else
+            m_tail = n.prev;
+        n.prev = n.next = npos;
+    }
+
+    void _push_front(index_type idx) {
+        node &n = m_nodes[idx];
+        n.prev = npos;
+        n.next = m_head;
+        if (m_head != npos)
+            m_nodes[m_head].prev = idx;
+        m_head = idx;
+        if (m_tail == npos)
+            m_tail = idx;
+    }
+};
+
+/**
+ * fixed capacity cache approximating lru with a single reference bit per entry,
+ * hits only set the bit so there is no list to maintain
+ * @note all memory is allocated on construction, entries are constructed on insert and destroyed on erase/eviction
+ */
+template<class key_tp, class value_tp, class hash_type = std::hash<key_tp>,
+         class evict_type = detail::no_eviction_callback>
+class clock_cache {
+public:
+    using size_type = std::size_t;
+    using index_type = std::uint32_t;
+
+    struct node {
+        detail::uninitialized<key_tp> key;
+        detail::uninitialized<value_tp> value;
+    };
+
+    std::vector<node> m_nodes;
+    std::vector<std::uint8_t> m_referenced;
+    std::vector<index_type> m_free;
+    hash_table<key_tp, index_type, hash_type> m_index;
+    evict_type m_on_evict{};
+    index_type m_hand{};
+    size_type m_hits{};
+    size_type m_misses{};
+    size_type m_evictions{};
+
+    /**
+     * @param capacity maximum number of entries
+     * @param on_evict called with key and value of every entry evicted to make room for a new one
+     */
+    explicit clock_cache(size_type capacity, evict_type on_evict = {}, hash_type hasher = {})
+            : m_nodes(capacity), m_referenced(capacity), m_index(detail::cache_index_capacity(capacity), hasher),
+              m_on_evict{std::move(on_evict)} {
+        assert(capacity && capacity < std::numeric_limits<index_type>::max() && "invalid capacity");
+        m_free.reserve(capacity);
+        _reset_free_list();
+    }
+
+    clock_cache(clock_cache &&other) noexcept
+            : m_nodes{std::move(other.m_nodes)}, m_referenced{std::move(other.m_referenced)},
+              m_free{std::move(other.m_free)}, m_index{std::move(other.m_index)},
+              m_on_evict{std::move(other.m_on_evict)}, m_hand{std::exchange(other.m_hand, 0)},
+              m_hits{other.m_hits}, m_misses{other.m_misses}, m_evictions{other.m_evictions} {
+        other.m_nodes.clear();
+        other.m_free.clear();
+    }
+
+    clock_cache(clock_cache const &) = delete;
+
+    clock_cache &operator=(clock_cache const &) = delete;
+
+    ~clock_cache() {
+        _destroy_entries();
+    }
+
+    /**
+     * @brief looks up key and marks it as referenced
+     * @return pointer to value associated with key or nullptr if it isn't cached
+     */
+    [[nodiscard]] value_tp *find(key_tp const &key) {
+        const auto it = m_index.find(key);
+        if (it == m_index.end()) {
+            ++m_misses;
+            return nullptr;
+        }
+        ++m_hits;
+        m_referenced[it->second] = 1;
+        return &m_nodes[it->second].value.value;
+    }
+
+    /**
+     * @brief looks up key without touching reference bits or hit/miss counters
+     * @return pointer to value associated with key or nullptr if it isn't cached
+     */
+    [[nodiscard]] value_tp const *peek(key_tp const &key) const {
+        const auto it = m_index.find(key);
+        return it == m_index.end() ? nullptr : &m_nodes[it->second].value.value;
+    }
+
+    /**
+     * @return whether key is cached
+     */
+    [[nodiscard]] bool contains(key_tp const &key) const {
+        return m_index.contains(key);
+    }
+
+    /**
+     * @brief inserts or overwrites value at key, evicting the first unreferenced entry after the hand if full
+     * @return reference to value in cache
+     */
+    value_tp &insert(key_tp const &key, value_tp value) {
+        const auto it = m_index.find(key);
+        if (it != m_index.end()) {
+            m_referenced[it->second] = 1;
+            return m_nodes[it->second].value.value = std::move(value);
+        }
+        if (m_free.empty())
+            _evict();
+        const index_type idx = m_free.back();
+        m_free.pop_back();
+        std::construct_at(&m_nodes[idx].key.value, key);
+        std::construct_at(&m_nodes[idx].value.value, std::move(value));
+        m_referenced[idx] = 0;
+        m_index.emplace(key, idx);
+        return m_nodes[idx].value.value;
+    }
+
+    /**
+     * @brief removes key from cache without calling the eviction callback
+     * @return whether key was cached
+     */
+    bool erase(key_tp const &key) {
+        const auto it = m_index.find(key);
+        if (it == m_index.end())
+            return false;
+        const index_type idx = it->second;
+        m_index.erase(it);
+        _release(idx);
+        return true;
+    }
+
+    /**
+     * @brief remove all entries without calling the eviction callback, counters are kept
+     */
+    void clear() {
+        _destroy_entries();
+        m_index.clear();
+        std::fill(m_referenced.begin(), m_referenced.end(), 0);
+        m_hand = 0;
+        _reset_free_list();
+    }
+
+    void reset_stats() {
+        m_hits = m_misses = m_evictions = 0;
+    }
+
+    [[nodiscard]] size_type size() const { return m_nodes.size() - m_free.size(); }
+
+    [[nodiscard]] size_type capacity() const { return m_nodes.size(); }
+
+    [[nodiscard]] bool empty() const { return m_free.size() == m_nodes.size(); }
+
+    [[nodiscard]] size_type hits() const { return m_hits; }
+
+    [[nodiscard]] size_type misses() const { return m_misses; }
+
+    [[nodiscard]] size_type evictions() const { return m_evictions; }
+
+private:
+    void _reset_free_list() {
+        m_free.clear();
+        for (index_type i = static_cast<index_type>(m_nodes.size()); i-- > 0;)
+            m_free.push_back(i);
+    }
+
+    [[nodiscard]] index_type _advance(index_type idx) const {
+        return idx + 1 < m_nodes.size() ? idx + 1 : 0;
+    }
+
+    // only called when every slot is in use
+    void _evict() {
+        while (m_referenced[m_hand]) {
+            m_referenced[m_hand] = 0;
+            m_hand = _advance(m_hand);
+        }
+        const index_type idx = m_hand;
+        m_hand = _advance(m_hand);
+        m_on_evict(std::as_const(m_nodes[idx].key.value), m_nodes[idx].value.value);
+        m_index.erase(m_nodes[idx].key.value);
+        _release(idx);
+        ++m_evictions;
+    }
+
+    /**
+     * @brief destroys the entry at idx, which is already out of the index, and returns its slot to the free list
+     */
+    void _release(index_type idx) {
+        std::destroy_at(&m_nodes[idx].key.value);
+        std::destroy_at(&m_nodes[idx].value.value);
+        m_referenced[idx] = 0;
+        m_free.push_back(idx);
+    }
+
+    // the index maps every cached key to its slot, so it is the list of live entries
+    void _destroy_entries() {
+        for (auto &&[key, idx]: m_index) {
+            std::destroy_at(&m_nodes[idx].key.value);
+            std::destroy_at(&m_nodes[idx].value.value);
+        }
+    }
+};
+} // namespace lmj
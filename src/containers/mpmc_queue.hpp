@@ -0,0 +1,194 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "container_helpers.hpp"
+
+namespace lmj {
+/**
+ * bounded lock free queue for any number of producers and consumers (Vyukov style), every slot has a sequence
+ * number saying whose turn it is, so producers and consumers only contend on the slot they use
+ * @tparam _capacity power of two number of slots stored inline, or 0 to pass the capacity to the constructor
+ * @note try_push and try_pop never block, push and pop take a ticket and sleep on their slot's sequence with
+ * std::atomic wait, a futex on linux, until its turn comes
+ */
+template<class T, std::size_t _capacity = 0>
+class mpmc_queue {
+    static_assert(_capacity == 0 || std::has_single_bit(_capacity), "capacity must be a power of two");
+
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+
+    /**
+     * padded to a cache line so neighbouring slots used by different threads don't false share
+     */
+    struct alignas(detail::cache_line_size) slot {
+        std::atomic<size_type> sequence;
+        detail::uninitialized<T> storage;
+    };
+
+    static constexpr bool dynamic_capacity = _capacity == 0;
+
+    alignas(detail::cache_line_size) std::atomic<size_type> m_enqueue_pos{0};
+    alignas(detail::cache_line_size) std::atomic<size_type> m_dequeue_pos{0};
+    alignas(detail::cache_line_size) size_type m_mask = _capacity - 1;
+    std::conditional_t<dynamic_capacity, std::unique_ptr<slot[]>, slot[_capacity ? _capacity : 1]> m_slots;
+
+    mpmc_queue() requires(!dynamic_capacity) {
+        _init();
+    }
+
+    /**
+     * @param capacity rounded up to a power of two
+     */
+    explicit mpmc_queue(size_type capacity) requires dynamic_capacity
+            : m_mask{std::bit_ceil(std::max<size_type>(capacity, 1)) - 1}, m_slots{new slot[m_mask + 1]} {
+        _init();
+    }
+
+    mpmc_queue(mpmc_queue const &) = delete;
+
+    mpmc_queue &operator=(mpmc_queue const &) = delete;
+
+    ~mpmc_queue() {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            const size_type last = m_enqueue_pos.load(std::memory_order_relaxed);
+            for (size_type pos = m_dequeue_pos.load(std::memory_order_relaxed); pos < last; ++pos)
+                if (_slot(pos).sequence.load(std::memory_order_relaxed) == pos + 1)
+                    std::destroy_at(&_slot(pos).storage.value);
+        }
+    }
+
+    /**
+     * @return whether there was room for the element constructed from args
+     */
+    template<class... Args>
+    bool try_emplace(Args &&...args) {
+        size_type pos = m_enqueue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            slot &s = _slot(pos);
+            const size_type sequence = s.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::make_signed_t<size_type>>(sequence - pos);
+            if (diff == 0) {
+                if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    _publish(s, pos + 1, std::forward<Args>(args)...);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // the slot still holds the element from one lap ago
+            } else {
+                pos = m_enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool try_push(T const &value) {
+        return try_emplace(value);
+    }
+
+    bool try_push(T &&value) {
+        return try_emplace(std::move(value));
+    }
+
+    /**
+     * @return the oldest element that is ready, if there is one
+     */
+    std::optional<T> try_pop() {
+        size_type pos = m_dequeue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            slot &s = _slot(pos);
+            const size_type sequence = s.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::make_signed_t<size_type>>(sequence - (pos + 1));
+            if (diff == 0) {
+                if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    return _consume(s, pos);
+            } else if (diff < 0) {
+                return std::nullopt;
+            } else {
+                pos = m_dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief constructs an element from args, sleeping while the queue is full
+     */
+    template<class... Args>
+    void emplace(Args &&...args) {
+        const size_type pos = m_enqueue_pos.fetch_add(1, std::memory_order_relaxed);
+        slot &s = _slot(pos);
+        _wait_for(s, pos);
+        _publish(s, pos + 1, std::forward<Args>(args)...);
+    }
+
+    void push(T const &value) {
+        emplace(value);
+    }
+
+    void push(T &&value) {
+        emplace(std::move(value));
+    }
+
+    /**
+     * @return the oldest element, sleeps while the queue is empty
+     */
+    T pop() {
+        const size_type pos = m_dequeue_pos.fetch_add(1, std::memory_order_relaxed);
+        slot &s = _slot(pos);
+        _wait_for(s, pos + 1);
+        return *_consume(s, pos);
+    }
+
+    /**
+     * @return number of elements, only a snapshot while other threads are running
+     */
+    [[nodiscard]] size_type size() const {
+        const size_type dequeued = m_dequeue_pos.load(std::memory_order_acquire);
+        const size_type enqueued = m_enqueue_pos.load(std::memory_order_acquire);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+
+    [[nodiscard]] bool empty() const { return size() == 0; }
+
+    [[nodiscard]] size_type capacity() const { return m_mask + 1; }
+
+private:
+    void _init() {
+        for (size_type i = 0; i <= m_mask; ++i)
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] slot &_slot(size_type pos) {
+        return m_slots[pos & m_mask];
+    }
+
+    static void _wait_for(slot &s, size_type sequence) {
+        for (size_type current; (current = s.sequence.load(std::memory_order_acquire)) != sequence;)
+            s.sequence.wait(current, std::memory_order_acquire);
+    }
+
+    template<class... Args>
+    static void _publish(slot &s, size_type sequence, Args &&...args) {
+        std::construct_at(&s.storage.value, std::forward<Args>(args)...);
+        s.sequence.store(sequence, std::memory_order_release);
+        s.sequence.notify_all();
+    }
+
+    std::optional<T> _consume(slot &s, size_type pos) {
+        std::optional<T> result{std::move(s.storage.value)};
+        std::destroy_at(&s.storage.value);
+        s.sequence.store(pos + m_mask + 1, std::memory_order_release);
+        s.sequence.notify_all();
+        return result;
+    }
+};
+} // namespace lmj
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "container_helpers.hpp"
+#include "hash_table.hpp"
+
+namespace lmj {
+namespace detail {
+/**
+ * @return partition of hash when there are 2^bits partitions, taken from the high bits of the
+ * mixed hash so the bits hash_table uses to place keys within a partition stay spread out
+ */
+constexpr std::size_t partition_of(std::uint64_t hash, unsigned bits) {
+    return bits ? static_cast<std::size_t>(mix64(hash) >> (64 - bits)) : 0;
+}
+
+/**
+ * @return smallest number of bits b so that 2^b >= n
+ */
+constexpr unsigned partition_bits_for(std::size_t n) {
+    unsigned bits = 0;
+    while ((std::size_t{1} << bits) < n)
+        ++bits;
+    return bits;
+}
+} // namespace detail
+
+/**
+ * hash table split into 2^bits independent hash_tables by the high bits of the key hash,
+ * every partition can be built and modified by a different thread
+ */
+template<class key_tp, class value_tp, class hash_type = std::hash<key_tp>>
+class partitioned_hash_table {
+public:
+    using key_type = key_tp;
+    using mapped_type = value_tp;
+    using table_type = hash_table<key_tp, value_tp, hash_type>;
+    using size_type = std::size_t;
+
+    std::vector<table_type> m_partitions;
+    unsigned m_bits{};
+    hash_type m_hasher{};
+
+    explicit partitioned_hash_table(unsigned bits = 0, hash_type hasher = {})
+            : m_partitions(size_type{1} << bits, table_type{hasher}), m_bits{bits}, m_hasher{hasher} {
+        assert(bits < 32 && "too many partitions");
+    }
+
+    [[nodiscard]] size_type partition_index(key_tp const &key) const {
+        return detail::partition_of(static_cast<std::uint64_t>(m_hasher(key)), m_bits);
+    }
+
+    [[nodiscard]] table_type &partition(size_type idx) { return m_partitions[idx]; }
+
+    [[nodiscard]] table_type const &partition(size_type idx) const { return m_partitions[idx]; }
+
+    [[nodiscard]] size_type partition_count() const { return m_partitions.size(); }
+
+    [[nodiscard]] unsigned partition_bits() const { return m_bits; }
+
+    /**
+     * @return reference to value associated with key or default constructs value if it doesn't exist
+     */
+    [[nodiscard]] value_tp &operator[](key_tp const &key) { return m_partitions[partition_index(key)][key]; }
+
+    /**
+     * @return value at key or fails
+     */
+    [[nodiscard]] value_tp const &at(key_tp const &key) const { return m_partitions[partition_index(key)].at(key); }
+
+    [[nodiscard]] bool contains(key_tp const &key) const { return m_partitions[partition_index(key)].contains(key); }
+
+    void erase(key_tp const &key) { m_partitions[partition_index(key)].erase(key); }
+
+    /**
+     * @brief calls f with every key value pair
+     */
+    template<class F>
+    void for_each(F &&f) {
+        for (auto &partition: m_partitions)
+            for (auto &p: partition)
+                f(p);
+    }
+
+    template<class F>
+    void for_each(F &&f) const {
+        for (auto const &partition: m_partitions)
+            for (auto const &p: partition)
+                f(p);
+    }
+
+    [[nodiscard]] size_type size() const {
+        size_type result = 0;
+        for (auto const &partition: m_partitions)
+            result += partition.size();
+        return result;
+    }
+
+    [[nodiscard]] bool empty() const { return size() == 0; }
+
+    void clear() {
+        for (auto &partition: m_partitions)
+            partition.clear();
+    }
+};
+} // namespace lmj
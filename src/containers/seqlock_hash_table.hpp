@@ -0,0 +1,143 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+
+#include "../utils/seqlock.hpp"
+#include "static_hash_table.hpp"
+
+namespace lmj {
+/**
+ * static_hash_table shared between one writer thread and any number of reader threads, the writer updates it
+ * under a seqlock and readers look up keys lock free, retrying if a write happened meanwhile
+ * @note readers only copy keys, values and control words with relaxed atomic loads and never dereference them,
+ * so a torn read is harmless and discarded, which is why keys and values have to be trivially copyable
+ */
+template<class key_tp, class value_tp, std::size_t _capacity, class hash_type = lmj::hash<key_tp>>
+class seqlock_static_hash_table {
+    static_assert(std::is_trivially_copyable_v<key_tp> && std::is_trivially_copyable_v<value_tp>,
+                  "readers copy keys and values while they may be written");
+    static_assert(std::is_default_constructible_v<key_tp> && std::is_default_constructible_v<value_tp>,
+                  "every slot holds a pair from construction on");
+
+public:
+    using table_type = static_hash_table<key_tp, value_tp, _capacity, hash_type>;
+    using key_type = key_tp;
+    using mapped_type = value_tp;
+    using size_type = std::size_t;
+
+    table_type m_table{};
+    seqlock m_lock{};
+
+    seqlock_static_hash_table() {
+        _construct_slots();
+    }
+
+    explicit seqlock_static_hash_table(hash_type hasher) : m_table{hasher} {
+        _construct_slots();
+    }
+
+    seqlock_static_hash_table(seqlock_static_hash_table const &) = delete;
+
+    seqlock_static_hash_table &operator=(seqlock_static_hash_table const &) = delete;
+
+    /**
+     * @return copy of the value of key, if it exists
+     */
+    [[nodiscard]] std::optional<value_tp> find(key_tp const &key) const {
+        return m_lock.read([&]() -> std::optional<value_tp> {
+            const size_type idx = _find_index(key);
+            if (idx == _capacity)
+                return std::nullopt;
+            return detail::seqlock_load<value_tp>(std::addressof(m_table._slot(idx).second));
+        });
+    }
+
+    [[nodiscard]] bool contains(key_tp const &key) const {
+        return m_lock.read([&] { return _find_index(key) != _capacity; });
+    }
+
+    [[nodiscard]] size_type size() const {
+        return m_table._size_relaxed();
+    }
+
+    [[nodiscard]] bool empty() const { return size() == 0; }
+
+    [[nodiscard]] static constexpr size_type capacity() { return _capacity; }
+
+    /**
+     * @return whether key was newly inserted, otherwise its value was overwritten
+     * @note writer only
+     */
+    bool insert_or_assign(key_tp const &key, value_tp const &value) {
+        return m_lock.write([&] {
+            size_type idx = _find_index(key);
+            if (idx != _capacity) {
+                detail::seqlock_store(std::addressof(m_table._slot(idx).second), value);
+                return false;
+            }
+            assert(m_table.size() < _capacity && "seqlock_static_hash_table is full");
+            idx = m_table._get_hash(key);
+            while (m_table._is_active(idx))
+                idx = idx + 1 < _capacity ? idx + 1 : 0;
+            detail::seqlock_store(std::addressof(m_table._slot(idx).first), key);
+            detail::seqlock_store(std::addressof(m_table._slot(idx).second), value);
+            m_table._set_state_relaxed(idx, table_type::ACTIVE);
+            m_table._set_size_relaxed(m_table.size() + 1);
+            return true;
+        });
+    }
+
+    /**
+     * @return whether key was in the table
+     * @note writer only
+     */
+    bool erase(key_tp const &key) {
+        return m_lock.write([&] {
+            const size_type idx = _find_index(key);
+            if (idx == _capacity)
+                return false;
+            m_table._set_state_relaxed(idx, table_type::TOMBSTONE);
+            m_table._set_size_relaxed(m_table.size() - 1);
+            return true;
+        });
+    }
+
+    /**
+     * @note writer only
+     */
+    void clear() {
+        m_lock.write([&] {
+            for (size_type i = 0; i < _capacity; ++i)
+                m_table._set_state_relaxed(i, table_type::INACTIVE);
+            m_table._set_size_relaxed(0);
+        });
+    }
+
+    /**
+     * @return the underlying table, only safe to use from the writer thread
+     */
+    [[nodiscard]] table_type const &table() const { return m_table; }
+
+private:
+    /**
+     * @brief starts the lifetime of the pair in every slot, keys and values are trivially copyable and never
+     * destroyed, so afterwards writes only overwrite members with seqlock_store
+     */
+    void _construct_slots() {
+        for (size_type i = 0; i < _capacity; ++i)
+            std::construct_at(std::addressof(m_table._slot(i)));
+    }
+
+    [[nodiscard]] size_type _find_index(key_tp const &key) const {
+        return detail::seqlock_find_index(
+                key, static_cast<size_type>(m_table._get_hash(key)), _capacity, m_table.m_states.tag(table_type::INACTIVE),
+                m_table.m_states.tag(table_type::ACTIVE), [&](size_type idx) { return m_table._load_state_relaxed(idx); },
+                [&](size_type idx) { return detail::seqlock_load<key_tp>(std::addressof(m_table._slot(idx).first)); });
+    }
+};
+} // namespace lmj
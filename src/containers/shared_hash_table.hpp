@@ -0,0 +1,214 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+
+#include "../utils/seqlock.hpp"
+#include "container_helpers.hpp"
+#include "static_hash_table.hpp"
+
+namespace lmj {
+/**
+ * fixed capacity hash table meant to live in memory shared between processes, like a shm_open + mmap segment,
+ * it holds no pointers and is trivially copyable, so it can be mapped at any address and copied bytewise
+ * @note one writer at a time updates it under a seqlock while any number of readers, in any process,
+ * read lock free and retry if they raced with a write
+ * @note create it in place with create(memory) in one process, others validate the layout with attach(memory)
+ */
+template<class key_tp, class value_tp, std::size_t _capacity, class hash_type = lmj::hash<key_tp>>
+class shared_static_hash_table {
+    static_assert(_capacity && "a table with a capacity of zero is not allowed");
+    static_assert(std::is_trivially_copyable_v<key_tp> && std::is_trivially_copyable_v<value_tp>,
+                  "keys and values are shared as raw bytes");
+    static_assert(std::is_empty_v<hash_type> && std::is_trivially_default_constructible_v<hash_type>,
+                  "every process has to hash the same way without shared state");
+
+    enum active_enum : std::uint8_t {
+        INACTIVE = 0,
+        ACTIVE = 1,
+        TOMBSTONE = 2,
+    };
+
+public:
+    using key_type = key_tp;
+    using mapped_type = value_tp;
+    using size_type = std::size_t;
+
+    struct alignas(std::uint64_t) slot {
+        key_tp key;
+        value_tp value;
+    };
+
+    /**
+     * @brief describes the layout, attach refuses memory written by an incompatible table
+     */
+    struct header {
+        std::uint64_t magic;
+        std::uint32_t version;
+        std::uint32_t slot_size;
+        std::uint64_t capacity;
+        std::uint64_t total_size;
+
+        bool operator==(header const &) const = default;
+    };
+
+    static constexpr std::uint64_t magic = 0x31627468736a6d6cULL; // "lmjshtb1"
+    static constexpr std::uint32_t version = 1;
+    static constexpr header expected_header{magic, version, sizeof(slot), _capacity, 0};
+
+    header m_header;
+    seqlock m_lock{};
+    std::uint64_t m_elem_count = 0;
+    std::uint8_t m_states[_capacity]{};
+    alignas(slot) unsigned char m_slots[_capacity * sizeof(slot)];
+
+    shared_static_hash_table() : m_header{expected_header} {
+        m_header.total_size = sizeof(shared_static_hash_table);
+    }
+
+    /**
+     * @brief constructs an empty table in memory, which must be at least sizeof(shared_static_hash_table) bytes
+     */
+    static shared_static_hash_table *create(void *memory) {
+        assert(reinterpret_cast<std::uintptr_t>(memory) % alignof(shared_static_hash_table) == 0 && "misaligned memory");
+        return std::construct_at(static_cast<shared_static_hash_table *>(memory));
+    }
+
+    /**
+     * @return the table another process created in memory, throws if it was created with a different layout
+     */
+    static shared_static_hash_table *attach(void *memory) {
+        auto *table = std::launder(static_cast<shared_static_hash_table *>(memory));
+        header h = table->m_header;
+        if (h.total_size != sizeof(shared_static_hash_table))
+            throw std::runtime_error("shared_static_hash_table size mismatch");
+        h.total_size = 0;
+        if (h != expected_header)
+            throw std::runtime_error("shared_static_hash_table layout mismatch");
+        return table;
+    }
+
+    [[nodiscard]] std::optional<value_tp> find(key_tp const &key) const {
+        return m_lock.read([&]() -> std::optional<value_tp> {
+            const size_type idx = _find_index(key);
+            if (idx == _capacity)
+                return std::nullopt;
+            return _load_slot(idx).value;
+        });
+    }
+
+    [[nodiscard]] bool contains(key_tp const &key) const {
+        return m_lock.read([&] { return _find_index(key) != _capacity; });
+    }
+
+    [[nodiscard]] size_type size() const {
+        return std::atomic_ref<std::uint64_t>{const_cast<std::uint64_t &>(m_elem_count)}.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] bool empty() const { return size() == 0; }
+
+    [[nodiscard]] static constexpr size_type capacity() { return _capacity; }
+
+    /**
+     * @return whether key was newly inserted, otherwise its value was overwritten
+     * @note writer only
+     */
+    bool insert_or_assign(key_tp const &key, value_tp const &value) {
+        return m_lock.write([&] {
+            size_type idx = _get_hash(key), writable = _capacity;
+            for (size_type i = 0; i < _capacity; ++i, idx = _new_idx(idx)) {
+                const std::uint8_t state = _load_state(idx);
+                if (state != ACTIVE) {
+                    if (writable == _capacity)
+                        writable = idx;
+                    if (state == INACTIVE)
+                        break;
+                } else if (_load_slot(idx).key == key) {
+                    detail::seqlock_store(_slot_ptr(idx), slot{key, value});
+                    return false;
+                }
+            }
+            assert(writable != _capacity && "shared_static_hash_table is full");
+            detail::seqlock_store(_slot_ptr(writable), slot{key, value});
+            _store_state(writable, ACTIVE);
+            _store_size(size() + 1);
+            return true;
+        });
+    }
+
+    /**
+     * @return whether key was in the table
+     * @note writer only
+     */
+    bool erase(key_tp const &key) {
+        return m_lock.write([&] {
+            const size_type idx = _find_index(key);
+            if (idx == _capacity)
+                return false;
+            _store_state(idx, TOMBSTONE);
+            _store_size(size() - 1);
+            return true;
+        });
+    }
+
+    /**
+     * @note writer only
+     */
+    void clear() {
+        m_lock.write([&] {
+            for (size_type i = 0; i < _capacity; ++i)
+                _store_state(i, INACTIVE);
+            _store_size(0);
+        });
+    }
+
+private:
+    [[nodiscard]] static size_type _get_hash(key_tp const &key) {
+        const auto hash = static_cast<size_type>(detail::mix64(static_cast<std::uint64_t>(hash_type{}(key))));
+        if constexpr (_capacity & (_capacity - 1))
+            return hash % _capacity;
+        else
+            return hash & (_capacity - 1);
+    }
+
+    [[nodiscard]] static size_type _new_idx(size_type idx) {
+        return idx + 1 < _capacity ? idx + 1 : 0;
+    }
+
+    [[nodiscard]] void *_slot_ptr(size_type idx) const {
+        return const_cast<unsigned char *>(m_slots + idx * sizeof(slot));
+    }
+
+    [[nodiscard]] slot _load_slot(size_type idx) const {
+        return detail::seqlock_load<slot>(_slot_ptr(idx));
+    }
+
+    [[nodiscard]] std::uint8_t _load_state(size_type idx) const {
+        return std::atomic_ref<std::uint8_t>{const_cast<std::uint8_t &>(m_states[idx])}.load(std::memory_order_relaxed);
+    }
+
+    void _store_state(size_type idx, active_enum state) {
+        std::atomic_ref<std::uint8_t>{m_states[idx]}.store(state, std::memory_order_relaxed);
+    }
+
+    void _store_size(size_type size) {
+        std::atomic_ref<std::uint64_t>{m_elem_count}.store(size, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] size_type _find_index(key_tp const &key) const {
+        return detail::seqlock_find_index(
+                key, _get_hash(key), _capacity, std::uint8_t{INACTIVE}, std::uint8_t{ACTIVE},
+                [&](size_type idx) { return _load_state(idx); }, [&](size_type idx) { return _load_slot(idx).key; });
+    }
+};
+
+// tests
+static_assert(std::is_trivially_copyable_v<shared_static_hash_table<int, double, 100>>);
+static_assert(std::is_trivially_copyable_v<shared_static_hash_table<std::uint64_t, char, 64>>);
+} // namespace lmj
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include "container_helpers.hpp"
+#include "hash_table.hpp"
+
+namespace lmj {
+/**
+ * estimates the number of distinct keys added using 2^precision registers,
+ * the standard error is about 1.04 / sqrt(2^precision)
+ * @note starts out sparse, storing only registers that were touched, and switches to a dense array of
+ * 2^precision bytes right before the sparse table would grow to that size, so it never uses more than dense
+ */
+template<class key_tp, class hash_type = std::hash<key_tp>>
+class hyperloglog {
+public:
+    using key_type = key_tp;
+    using size_type = std::size_t;
+    using register_type = std::uint8_t;
+    using sparse_policy = doubling_growth_policy<>;
+    using sparse_table = hash_table<std::uint32_t, register_type, std::hash<std::uint32_t>, sparse_policy>;
+
+    // a pair and its control word
+    static constexpr size_type sparse_slot_bytes =
+            sizeof(typename sparse_table::pair_type) + sizeof(typename sparse_table::bool_type);
+
+    std::vector<register_type> m_registers; // empty while sparse
+    sparse_table m_sparse;
+    unsigned m_precision{};
+    hash_type m_hasher{};
+
+    explicit hyperloglog(unsigned precision = 14, hash_type hasher = {}) : m_precision{precision}, m_hasher{hasher} {
+        assert(4 <= precision && precision <= 18 && "unsupported precision");
+    }
+
+    void add(key_tp const &key) {
+        _add_hash(detail::mix64(static_cast<std::uint64_t>(m_hasher(key))));
+    }
+
+    template<class Iter>
+    void add_many(Iter first, Iter last) {
+        constexpr size_type batch_size = 16;
+        std::uint64_t hashes[batch_size];
+        while (first != last) {
+            size_type count = 0;
+            for (; count < batch_size && first != last; ++count, ++first)
+                hashes[count] = detail::mix64(static_cast<std::uint64_t>(m_hasher(*first)));
+            for (size_type i = 0; i < count; ++i)
+                _add_hash(hashes[i]);
+        }
+    }
+
+    /**
+     * @return estimated number of distinct keys added
+     */
+    [[nodiscard]] double estimate() const {
+        const double m = static_cast<double>(register_count());
+        double sum = 0;
+        size_type zeros = 0;
+        if (is_sparse()) {
+            zeros = register_count() - m_sparse.size();
+            sum = static_cast<double>(zeros);
+            for (auto const &[idx, rho]: m_sparse)
+                sum += std::ldexp(1.0, -rho);
+        } else {
+            for (register_type rho: m_registers) {
+                zeros += rho == 0;
+                sum += std::ldexp(1.0, -rho);
+            }
+        }
+        const double alpha = 0.7213 / (1 + 1.079 / m);
+        const double raw = alpha * m * m / sum;
+        if (raw <= 2.5 * m && zeros) // small range correction, linear counting
+            return m * std::log(m / static_cast<double>(zeros));
+        return raw;
+    }
+
+    /**
+     * @brief merges other into this sketch, afterwards it estimates the size of the union
+     */
+    hyperloglog &merge(hyperloglog const &other) {
+        assert(m_precision == other.m_precision && "can only merge sketches of the same precision");
+        if (other.is_sparse()) {
+            for (auto const &[idx, rho]: other.m_sparse)
+                _update(idx, rho);
+            return *this;
+        }
+        if (is_sparse())
+            _to_dense();
+        register_type *dst = m_registers.data();
+        register_type const *src = other.m_registers.data();
+        for (size_type i = 0; i < m_registers.size(); ++i)
+            dst[i] = std::max(dst[i], src[i]);
+        return *this;
+    }
+
+    void clear() {
+        m_registers = {};
+        m_sparse = {};
+    }
+
+    [[nodiscard]] bool is_sparse() const { return m_registers.empty(); }
+
+    [[nodiscard]] size_type register_count() const { return size_type{1} << m_precision; }
+
+    /**
+     * @return approximate number of bytes used by the registers
+     */
+    [[nodiscard]] size_type memory_usage() const {
+        return is_sparse() ? m_sparse.capacity() * sparse_slot_bytes : m_registers.size();
+    }
+
+private:
+    void _add_hash(std::uint64_t hash) {
+        const auto idx = static_cast<std::uint32_t>(hash >> (64 - m_precision));
+        const auto rho = static_cast<register_type>(
+                std::countl_zero((hash << m_precision) | (std::uint64_t{1} << (m_precision - 1))) + 1);
+        _update(idx, rho);
+    }
+
+    void _update(std::uint32_t idx, register_type rho) {
+        if (is_sparse() && m_sparse._should_grow() && !m_sparse.contains(idx) &&
+            sparse_policy::grow(m_sparse.capacity()) * sparse_slot_bytes >= register_count())
+            _to_dense();
+        if (!is_sparse()) {
+            m_registers[idx] = std::max(m_registers[idx], rho);
+            return;
+        }
+        register_type &r = m_sparse[idx];
+        r = std::max(r, rho);
+    }
+
+    void _to_dense() {
+        m_registers.assign(register_count(), 0);
+        for (auto const &[idx, rho]: m_sparse)
+            m_registers[idx] = rho;
+        m_sparse = {};
+    }
+};
+
+/**
+ * estimates how often every key was added, estimates never undercount and overcount by at most
+ * epsilon * total with probability 1 - delta when constructed with from_error
+ * @note uses conservative update, only the counters equal to the current minimum are raised
+ */
+template<class key_tp, class counter_type = std::uint32_t, class hash_type = std::hash<key_tp>>
+class count_min_sketch {
+public:
+    using key_type = key_tp;
+    using size_type = std::size_t;
+
+    std::vector<counter_type> m_counters; // depth rows of width counters
+    size_type m_width{};
+    size_type m_depth{};
+    std::uint64_t m_total{};
+    hash_type m_hasher{};
+
+    count_min_sketch(size_type width, size_type depth, hash_type hasher = {})
+            : m_counters(width * depth), m_width{width}, m_depth{depth}, m_hasher{hasher} {
+        assert(width && depth && width <= std::numeric_limits<std::uint32_t>::max() && "invalid dimensions");
+    }
+
+    /**
+     * @param epsilon maximum overcount as a fraction of the total count
+     * @param delta probability of exceeding that
+     */
+    [[nodiscard]] static count_min_sketch from_error(double epsilon, double delta, hash_type hasher = {}) {
+        assert(0 < epsilon && 0 < delta && delta < 1);
+        return count_min_sketch{static_cast<size_type>(std::ceil(std::exp(1.0) / epsilon)),
+                                static_cast<size_type>(std::ceil(std::log(1 / delta))), hasher};
+    }
+
+    void add(key_tp const &key, counter_type count = 1) {
+        _add_hash(detail::mix64(static_cast<std::uint64_t>(m_hasher(key))), count);
+    }
+
+    template<class Iter>
+    void add_many(Iter first, Iter last) {
+        constexpr size_type batch_size = 16;
+        std::uint64_t hashes[batch_size];
+        while (first != last) {
+            size_type count = 0;
+            for (; count < batch_size && first != last; ++count, ++first) {
+                hashes[count] = detail::mix64(static_cast<std::uint64_t>(m_hasher(*first)));
+#if defined(__GNUC__) || defined(__clang__)
+                __builtin_prefetch(&m_counters[_index(hashes[count], 0)]);
+#endif
+            }
+            for (size_type i = 0; i < count; ++i)
+                _add_hash(hashes[i], 1);
+        }
+    }
+
+    /**
+     * @return estimated number of times key was added, never less than the real count
+     */
+    [[nodiscard]] counter_type estimate(key_tp const &key) const {
+        return _estimate_hash(detail::mix64(static_cast<std::uint64_t>(m_hasher(key))));
+    }
+
+    /**
+     * @brief adds the counts of other, which must have the same dimensions and hasher
+     */
+    count_min_sketch &merge(count_min_sketch const &other) {
+        assert(m_width == other.m_width && m_depth == other.m_depth && "can only merge sketches of the same size");
+        counter_type *dst = m_counters.data();
+        counter_type const *src = other.m_counters.data();
+        for (size_type i = 0; i < m_counters.size(); ++i)
+            dst[i] += src[i];
+        m_total += other.m_total;
+        return *this;
+    }
+
+    void clear() {
+        std::fill(m_counters.begin(), m_counters.end(), counter_type{});
+        m_total = 0;
+    }
+
+    /**
+     * @return sum of all counts added
+     */
+    [[nodiscard]] std::uint64_t total() const { return m_total; }
+
+    [[nodiscard]] size_type width() const { return m_width; }
+
+    [[nodiscard]] size_type depth() const { return m_depth; }
+
+    [[nodiscard]] size_type memory_usage() const { return m_counters.size() * sizeof(counter_type); }
+
+private:
+    [[nodiscard]] size_type _index(std::uint64_t hash, size_type row) const {
+        // double hashing, h1 + row * h2 is pairwise independent enough per row
+        const auto h = static_cast<std::uint32_t>(hash) + static_cast<std::uint32_t>(row) * static_cast<std::uint32_t>((hash >> 32) | 1);
+        return row * m_width + static_cast<size_type>((std::uint64_t{h} * m_width) >> 32);
+    }
+
+    [[nodiscard]] counter_type _estimate_hash(std::uint64_t hash) const {
+        counter_type result = std::numeric_limits<counter_type>::max();
+        for (size_type row = 0; row < m_depth; ++row)
+            result = std::min(result, m_counters[_index(hash, row)]);
+        return result;
+    }
+
+    void _add_hash(std::uint64_t hash, counter_type count) {
+        const counter_type target = _estimate_hash(hash) + count;
+        for (size_type row = 0; row < m_depth; ++row) {
+            counter_type &c = m_counters[_index(hash, row)];
+            c = std::max(c, target);
+        }
+        m_total += count;
+    }
+};
+} // namespace lmj
@@ -0,0 +1,579 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "container_helpers.hpp"
+
+namespace lmj {
+/**
+ * vector that keeps up to _inline_capacity elements inline like static_vector and moves them to a heap
+ * allocation that grows geometrically once it needs more
+ * @note it only moves back inline on shrink_to_fit, so a vector that overflowed once doesn't reallocate
+ * every time it crosses _inline_capacity
+ */
+template<class T, std::size_t _inline_capacity>
+class small_vector {
+public:
+    static_assert(_inline_capacity && "use std::vector if nothing should be stored inline");
+    using value_type = T;
+    using reference = value_type &;
+    using const_reference = value_type const &;
+    using pointer = value_type *;
+    using const_pointer = const value_type *;
+    using iterator = pointer;
+    using size_type = std::size_t;
+    using difference_type = std::make_signed_t<size_type>;
+    using const_iterator = const_pointer;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    detail::uninitialized<value_type[_inline_capacity]> m_inline;
+    pointer m_heap = nullptr; // nullptr while the elements are inline
+    size_type m_size{};
+    size_type m_capacity = _inline_capacity;
+
+    constexpr small_vector() = default;
+
+    constexpr explicit small_vector(size_type n) {
+        reserve(n);
+        for (; m_size < n; ++m_size)
+            std::construct_at(data() + m_size);
+    }
+
+    constexpr explicit small_vector(size_type n, T const &value) {
+        reserve(n);
+        for (; m_size < n; ++m_size)
+            std::construct_at(data() + m_size, value);
+    }
+
+    template<std::input_iterator Iter>
+    constexpr explicit small_vector(Iter begin, Iter end) {
+        _append(begin, end);
+    }
+
+    constexpr small_vector(std::initializer_list<T> il) {
+        reserve(il.size());
+        _copy_construct(il.begin(), il.size());
+    }
+
+    constexpr small_vector(small_vector const &other) {
+        reserve(other.m_size);
+        _copy_construct(other.data(), other.m_size);
+    }
+
+    constexpr small_vector(small_vector &&other) noexcept {
+        _steal(std::move(other));
+    }
+
+    constexpr small_vector &operator=(small_vector const &other) {
+        if (this != &other) {
+            clear();
+            reserve(other.m_size);
+            _copy_construct(other.data(), other.m_size);
+        }
+        return *this;
+    }
+
+    constexpr small_vector &operator=(small_vector &&other) noexcept {
+        if (this != &other) {
+            clear();
+            _free();
+            _steal(std::move(other));
+        }
+        return *this;
+    }
+
+    constexpr ~small_vector() {
+        clear();
+        _free();
+    }
+
+    [[nodiscard]] constexpr size_type size() const {
+        return m_size;
+    }
+
+    [[nodiscard]] constexpr size_type capacity() const {
+        return m_capacity;
+    }
+
+    [[nodiscard]] static constexpr size_type inline_capacity() {
+        return _inline_capacity;
+    }
+
+    /**
+     * @return whether the elements are stored inline
+     */
+    [[nodiscard]] constexpr bool is_inline() const {
+        return m_heap == nullptr;
+    }
+
+    [[nodiscard]] constexpr size_type max_size() const {
+        return std::allocator_traits<std::allocator<T>>::max_size(std::allocator<T>{});
+    }
+
+    [[nodiscard]] constexpr pointer data() {
+        return m_heap ? m_heap : m_inline.value;
+    }
+
+    [[nodiscard]] constexpr const_pointer data() const {
+        return m_heap ? m_heap : m_inline.value;
+    }
+
+    /**
+     * @brief makes room for at least n elements
+     */
+    constexpr void reserve(size_type n) {
+        if (n > m_capacity)
+            _relocate(n);
+    }
+
+    /**
+     * @brief moves the elements back inline if they fit, otherwise to an allocation of exactly size() elements
+     */
+    constexpr void shrink_to_fit() {
+        if (m_heap && m_size < m_capacity)
+            _relocate(m_size);
+    }
+
+    template<class G>
+    constexpr auto &push_back(G &&elem) {
+        return emplace_back(std::forward<G>(elem));
+    }
+
+    template<class... Args>
+    constexpr auto &emplace_back(Args &&...args) {
+        if (m_size == m_capacity) {
+            // args may refer to an element, so construct the new one before relocating the others
+            const size_type new_capacity = std::max(2 * m_capacity, m_size + 1);
+            pointer new_data = std::allocator<T>{}.allocate(new_capacity);
+            std::construct_at(new_data + m_size, std::forward<Args>(args)...);
+            _move_elements(new_data);
+            _free();
+            m_heap = new_data;
+            m_capacity = new_capacity;
+        } else {
+            std::construct_at(data() + m_size, std::forward<Args>(args)...);
+        }
+        return data()[m_size++];
+    }
+
+    /**
+     * @brief inserts copies of [first, last) before pos, which must not point into this vector
+     * @return iterator to the first inserted element
+     */
+    template<std::input_iterator Iter>
+    constexpr iterator insert(const_iterator pos, Iter first, Iter last) {
+        assert(pos >= begin() && pos <= end());
+        const auto offset = static_cast<size_type>(pos - begin());
+        if constexpr (std::is_trivially_copyable_v<T> && std::forward_iterator<Iter>) {
+            if (!std::is_constant_evaluated()) {
+                const auto count = static_cast<size_type>(std::distance(first, last));
+                _grow_to(m_size + count);
+                T *gap = data() + offset;
+                std::memmove(gap + count, gap, (m_size - offset) * sizeof(T));
+                if constexpr (std::contiguous_iterator<Iter> && std::is_same_v<std::iter_value_t<Iter>, T>) {
+                    if (count)
+                        std::memcpy(gap, std::to_address(first), count * sizeof(T));
+                } else {
+                    std::copy(first, last, gap);
+                }
+                m_size += count;
+                return gap;
+            }
+        }
+        const size_type old_size = m_size;
+        _append(first, last);
+        std::rotate(begin() + offset, begin() + old_size, end());
+        return begin() + offset;
+    }
+
+    constexpr iterator insert(const_iterator pos, std::initializer_list<T> il) {
+        return insert(pos, il.begin(), il.end());
+    }
+
+    constexpr iterator insert(const_iterator pos, T const &value) {
+        return emplace(pos, value);
+    }
+
+    constexpr iterator insert(const_iterator pos, T &&value) {
+        return emplace(pos, std::move(value));
+    }
+
+    /**
+     * @brief constructs an element from args before pos, args may refer to elements of this vector
+     * @return iterator to the new element
+     */
+    template<class... Args>
+    constexpr iterator emplace(const_iterator pos, Args &&...args) {
+        assert(pos >= begin() && pos <= end());
+        const auto offset = pos - begin();
+        emplace_back(std::forward<Args>(args)...);
+        std::rotate(begin() + offset, end() - 1, end());
+        return begin() + offset;
+    }
+
+    /**
+     * @brief appends copies of the elements of range, which must not be this vector,
+     * memcpy if they are contiguous and trivially copyable
+     */
+    template<std::ranges::input_range R>
+    constexpr void append_range(R &&range) {
+        _append(std::ranges::begin(range), std::ranges::end(range));
+    }
+
+    /**
+     * @brief value initializes or destroys elements at the back until there are n
+     */
+    constexpr void resize(size_type n) {
+        if (n <= m_size) {
+            _destroy_from(n);
+            return;
+        }
+        _grow_to(n);
+        for (; m_size < n; ++m_size)
+            std::construct_at(data() + m_size);
+    }
+
+    /**
+     * @brief copies value or destroys elements at the back until there are n, value may be an element
+     */
+    constexpr void resize(size_type n, T const &value) {
+        if (n <= m_size) {
+            _destroy_from(n);
+            return;
+        }
+        if (n > m_capacity) {
+            const T copy = value;
+            _grow_to(n);
+            for (; m_size < n; ++m_size)
+                std::construct_at(data() + m_size, copy);
+            return;
+        }
+        for (; m_size < n; ++m_size)
+            std::construct_at(data() + m_size, value);
+    }
+
+    template<std::input_iterator Iter>
+    constexpr void assign(Iter first, Iter last) {
+        clear();
+        _append(first, last);
+    }
+
+    constexpr void assign(size_type n, T const &value) {
+        clear();
+        resize(n, value);
+    }
+
+    constexpr void assign(std::initializer_list<T> il) {
+        clear();
+        _grow_to(il.size());
+        _copy_construct(il.begin(), il.size());
+    }
+
+    [[nodiscard]] constexpr reference operator[](size_type idx) {
+        assert(idx < m_size && "no element to return");
+        return data()[idx];
+    }
+
+    [[nodiscard]] constexpr const_reference operator[](size_type idx) const {
+        assert(idx < m_size && "no element to return");
+        return data()[idx];
+    }
+
+    [[nodiscard]] constexpr reference front() {
+        assert(m_size && "no element to return");
+        return data()[0];
+    }
+
+    [[nodiscard]] constexpr const_reference front() const {
+        assert(m_size && "no element to return");
+        return data()[0];
+    }
+
+    [[nodiscard]] constexpr reference back() {
+        assert(m_size && "no element to return");
+        return data()[m_size - 1];
+    }
+
+    [[nodiscard]] constexpr const_reference back() const {
+        assert(m_size && "no element to return");
+        return data()[m_size - 1];
+    }
+
+    constexpr T pop_back() {
+        assert(m_size && "no element to pop");
+        auto res = std::move(data()[m_size - 1]);
+        std::destroy_at(data() + --m_size);
+        return res;
+    }
+
+    constexpr void erase(const_iterator iter) {
+        erase(iter, iter + 1);
+    }
+
+    constexpr void erase(const_iterator first, const_iterator last) {
+        assert(first >= begin() && first <= end());
+        assert(last >= first && last <= end());
+
+        if (first == last) return;
+
+        iterator i1 = begin() + (first - begin()), i2 = begin() + (last - begin());
+        const auto count = static_cast<size_type>(i2 - i1);
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            if (!std::is_constant_evaluated()) {
+                std::memmove(i1, i2, static_cast<size_type>(end() - i2) * sizeof(T));
+                m_size -= count;
+                return;
+            }
+        }
+        std::move(i2, end(), i1);
+        _destroy_from(m_size - count);
+    }
+
+    /**
+     * @brief destroys all elements, keeps the capacity
+     */
+    constexpr void clear() {
+        _destroy_from(0);
+    }
+
+    [[nodiscard]] constexpr bool empty() const {
+        return m_size == 0;
+    }
+
+    [[nodiscard]] constexpr const_iterator begin() const {
+        return const_iterator{data()};
+    }
+
+    [[nodiscard]] constexpr const_iterator end() const {
+        return begin() + m_size;
+    }
+
+    [[nodiscard]] constexpr iterator begin() {
+        return iterator{data()};
+    }
+
+    [[nodiscard]] constexpr iterator end() {
+        return begin() + m_size;
+    }
+
+    [[nodiscard]] constexpr const_iterator cbegin() const {
+        return begin();
+    }
+
+    [[nodiscard]] constexpr const_iterator cend() const {
+        return end();
+    }
+
+    [[nodiscard]] constexpr const_reverse_iterator rbegin() const {
+        return std::reverse_iterator{end()};
+    }
+
+    [[nodiscard]] constexpr const_reverse_iterator rend() const {
+        return std::reverse_iterator{begin()};
+    }
+
+    [[nodiscard]] constexpr reverse_iterator rbegin() {
+        return std::reverse_iterator{end()};
+    }
+
+    [[nodiscard]] constexpr reverse_iterator rend() {
+        return std::reverse_iterator{begin()};
+    }
+
+    [[nodiscard]] constexpr const_reverse_iterator crbegin() const {
+        return std::reverse_iterator{cend()};
+    }
+
+    [[nodiscard]] constexpr const_reverse_iterator crend() const {
+        return std::reverse_iterator{cbegin()};
+    }
+
+    template<std::size_t other_capacity>
+    [[nodiscard]] constexpr bool operator==(small_vector<T, other_capacity> const &other) const {
+        return std::equal(begin(), end(), other.begin(), other.end());
+    }
+
+    [[nodiscard]] std::vector<T> to_std_vector() const {
+        return std::vector(begin(), end());
+    }
+
+private:
+    /**
+     * @brief moves the elements to inline storage if new_capacity fits in it, otherwise to a new allocation
+     */
+    constexpr void _relocate(size_type new_capacity) {
+        assert(new_capacity >= m_size);
+        if (new_capacity <= _inline_capacity) {
+            if (!m_heap)
+                return;
+            pointer old_heap = m_heap;
+            const size_type old_capacity = m_capacity;
+            m_heap = nullptr;
+            _move_elements(m_inline.value, old_heap);
+            std::allocator<T>{}.deallocate(old_heap, old_capacity);
+            m_capacity = _inline_capacity;
+            return;
+        }
+        pointer new_data = std::allocator<T>{}.allocate(new_capacity);
+        _move_elements(new_data);
+        _free();
+        m_heap = new_data;
+        m_capacity = new_capacity;
+    }
+
+    /**
+     * @brief makes room for n elements, at least doubling the capacity like emplace_back when it has to grow
+     */
+    constexpr void _grow_to(size_type n) {
+        if (n > m_capacity)
+            _relocate(std::max(2 * m_capacity, n));
+    }
+
+    /**
+     * @brief copy constructs the elements of [first, last) after the current ones, growing once if their count is known
+     */
+    template<class Iter, class Sentinel>
+    constexpr void _append(Iter first, Sentinel last) {
+        if constexpr (std::contiguous_iterator<Iter> && std::sized_sentinel_for<Sentinel, Iter> &&
+                      std::is_same_v<std::iter_value_t<Iter>, T>) {
+            const auto count = static_cast<size_type>(last - first);
+            _grow_to(m_size + count);
+            _copy_construct(std::to_address(first), count);
+        } else {
+            if constexpr (std::forward_iterator<Iter>)
+                _grow_to(m_size + static_cast<size_type>(std::ranges::distance(first, last)));
+            for (; first != last; ++first)
+                emplace_back(*first);
+        }
+    }
+
+    /**
+     * @brief move constructs the elements into dst and destroys them in src, which defaults to data()
+     */
+    constexpr void _move_elements(pointer dst) {
+        _move_elements(dst, data());
+    }
+
+    constexpr void _move_elements(pointer dst, pointer src) {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            if (!std::is_constant_evaluated()) {
+                if (m_size)
+                    std::memcpy(dst, src, m_size * sizeof(T));
+                return;
+            }
+        }
+        for (size_type i = 0; i < m_size; ++i) {
+            std::construct_at(dst + i, std::move(src[i]));
+            std::destroy_at(src + i);
+        }
+    }
+
+    /**
+     * @brief copy constructs count elements from src after the current ones, which must fit
+     */
+    constexpr void _copy_construct(const_pointer src, size_type count) {
+        assert(m_size + count <= m_capacity);
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            if (!std::is_constant_evaluated()) {
+                if (count)
+                    std::memcpy(data() + m_size, src, count * sizeof(T));
+                m_size += count;
+                return;
+            }
+        }
+        for (size_type i = 0; i < count; ++i, ++m_size)
+            std::construct_at(data() + m_size, src[i]);
+    }
+
+    /**
+     * @brief takes the heap allocation of other or moves its inline elements, this must be empty and inline
+     */
+    constexpr void _steal(small_vector &&other) {
+        if (other.m_heap) {
+            m_heap = std::exchange(other.m_heap, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+            m_capacity = std::exchange(other.m_capacity, _inline_capacity);
+            return;
+        }
+        m_size = other.m_size;
+        _move_elements(m_inline.value, other.m_inline.value);
+        other.m_size = 0;
+    }
+
+    /**
+     * @brief destroys the elements from index new_size on
+     */
+    constexpr void _destroy_from(size_type new_size) {
+        if constexpr (!std::is_trivially_destructible_v<T>)
+            std::destroy(data() + new_size, data() + m_size);
+        m_size = new_size;
+    }
+
+    /**
+     * @brief releases the heap allocation, its elements must be destroyed or moved already
+     */
+    constexpr void _free() {
+        if (m_heap)
+            std::allocator<T>{}.deallocate(m_heap, m_capacity);
+        m_heap = nullptr;
+        m_capacity = _inline_capacity;
+    }
+};
+
+// tests
+static_assert([] {
+    small_vector<std::string, 2> v = {"a", "b"};
+    if (!v.is_inline())
+        return false;
+    for (int i = 0; i < 10; ++i)
+        v.push_back(v.front());
+    if (v.is_inline() || v.size() != 12 || v.back() != "a")
+        return false;
+    v.erase(v.begin() + 1, v.end() - 1);
+    v.shrink_to_fit();
+    small_vector<std::string, 2> moved = std::move(v);
+    return moved.is_inline() && moved.size() == 2 && moved[0] == "a" && v.empty();
+}());
+static_assert([] {
+    small_vector<int, 4> v(100, 3);
+    small_vector<int, 4> copy = v;
+    copy.erase(copy.begin(), copy.begin() + 98);
+    v = std::move(copy);
+    return v.size() == 2 && copy.empty() && v == small_vector<int, 4>{3, 3};
+}());
+static_assert([] {
+    small_vector<int, 4> v = {1, 5};
+    const int middle[] = {2, 3, 4};
+    v.insert(v.begin() + 1, std::begin(middle), std::end(middle));
+    v.append_range(std::array{6, 7});
+    v.emplace(v.begin(), 0);
+    v.resize(10);
+    if (v.is_inline() || v != small_vector<int, 10>{0, 1, 2, 3, 4, 5, 6, 7, 0, 0})
+        return false;
+    v.assign(3, 9);
+    return v == small_vector<int, 3>{9, 9, 9};
+}());
+static_assert([] {
+    small_vector<std::string, 2> v(2, "abc");
+    v.resize(5, v.front());
+    const std::string extra[] = {"x", "y"};
+    v.insert(v.begin(), std::begin(extra), std::end(extra));
+    v.insert(v.end(), v[1]);
+    v.resize(3);
+    v.assign({"a", "b", "c", "d"});
+    return v == small_vector<std::string, 4>{"a", "b", "c", "d"} && !v.is_inline();
+}());
+} // namespace lmj
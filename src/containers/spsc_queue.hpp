@@ -0,0 +1,163 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "container_helpers.hpp"
+
+namespace lmj {
+/**
+ * wait free bounded queue for exactly one producer thread and one consumer thread, elements live inline in a ring
+ * of _capacity slots
+ * @note head and tail are free running counters on their own cache lines, each side also keeps a cached copy of
+ * the other side's counter next to its own, so it only touches the other cache line when the ring looks full or empty
+ */
+template<class T, std::size_t _capacity>
+class spsc_queue {
+    static_assert(std::has_single_bit(_capacity), "capacity must be a power of two");
+
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+
+    // consumer side
+    alignas(detail::cache_line_size) std::atomic<size_type> m_head{0};
+    size_type m_tail_cache = 0;
+    // producer side
+    alignas(detail::cache_line_size) std::atomic<size_type> m_tail{0};
+    size_type m_head_cache = 0;
+    alignas(detail::cache_line_size) detail::uninitialized<T[_capacity]> m_slots;
+
+    constexpr spsc_queue() = default;
+
+    spsc_queue(spsc_queue const &) = delete;
+
+    spsc_queue &operator=(spsc_queue const &) = delete;
+
+    ~spsc_queue() {
+        if constexpr (!std::is_trivially_destructible_v<T>)
+            for (size_type i = m_head.load(std::memory_order_relaxed); i != m_tail.load(std::memory_order_relaxed); ++i)
+                std::destroy_at(_slot(i));
+    }
+
+    /**
+     * @return whether there was room for the element constructed from args
+     * @note producer only
+     */
+    template<class... Args>
+    bool try_emplace(Args &&...args) {
+        const size_type tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head_cache == _capacity) {
+            m_head_cache = m_head.load(std::memory_order_acquire);
+            if (tail - m_head_cache == _capacity)
+                return false;
+        }
+        std::construct_at(_slot(tail), std::forward<Args>(args)...);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_push(T const &value) {
+        return try_emplace(value);
+    }
+
+    bool try_push(T &&value) {
+        return try_emplace(std::move(value));
+    }
+
+    /**
+     * @brief pushes as many of the n elements from first as fit, publishing them at once
+     * @return number of elements pushed
+     * @note producer only
+     */
+    template<class Iter>
+    size_type push_n(Iter first, size_type n) {
+        const size_type tail = m_tail.load(std::memory_order_relaxed);
+        if (_capacity - (tail - m_head_cache) < n)
+            m_head_cache = m_head.load(std::memory_order_acquire);
+        n = std::min(n, _capacity - (tail - m_head_cache));
+        if constexpr (std::is_trivially_copyable_v<T> && std::contiguous_iterator<Iter> &&
+                      std::is_same_v<std::iter_value_t<Iter>, T>) {
+            // at most two memcpys, the second one after wrapping around the end of the ring
+            const size_type offset = tail & (_capacity - 1), first_part = std::min(n, _capacity - offset);
+            std::memcpy(_slot(tail), std::to_address(first), first_part * sizeof(T));
+            std::memcpy(_slot(0), std::to_address(first) + first_part, (n - first_part) * sizeof(T));
+        } else {
+            for (size_type i = 0; i < n; ++i, ++first)
+                std::construct_at(_slot(tail + i), *first);
+        }
+        m_tail.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+    /**
+     * @return the oldest element, if there is one
+     * @note consumer only
+     */
+    std::optional<T> try_pop() {
+        std::optional<T> result;
+        const size_type head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail_cache) {
+            m_tail_cache = m_tail.load(std::memory_order_acquire);
+            if (head == m_tail_cache)
+                return result;
+        }
+        result.emplace(std::move(*_slot(head)));
+        std::destroy_at(_slot(head));
+        m_head.store(head + 1, std::memory_order_release);
+        return result;
+    }
+
+    /**
+     * @brief move assigns up to n of the oldest elements to out, like std::move, releasing their slots at once
+     * @return number of elements popped
+     * @note consumer only
+     */
+    template<class Iter>
+    size_type pop_n(Iter out, size_type n) {
+        const size_type head = m_head.load(std::memory_order_relaxed);
+        if (m_tail_cache - head < n)
+            m_tail_cache = m_tail.load(std::memory_order_acquire);
+        n = std::min(n, m_tail_cache - head);
+        if constexpr (std::is_trivially_copyable_v<T> && std::contiguous_iterator<Iter> &&
+                      std::is_same_v<std::iter_value_t<Iter>, T>) {
+            const size_type offset = head & (_capacity - 1), first_part = std::min(n, _capacity - offset);
+            std::memcpy(std::to_address(out), _slot(head), first_part * sizeof(T));
+            std::memcpy(std::to_address(out) + first_part, _slot(0), (n - first_part) * sizeof(T));
+        } else {
+            for (size_type i = 0; i < n; ++i, ++out) {
+                *out = std::move(*_slot(head + i));
+                std::destroy_at(_slot(head + i));
+            }
+        }
+        m_head.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    /**
+     * @return number of elements, only a snapshot while the other side is running
+     */
+    [[nodiscard]] size_type size() const {
+        const size_type head = m_head.load(std::memory_order_acquire);
+        return m_tail.load(std::memory_order_acquire) - head;
+    }
+
+    [[nodiscard]] bool empty() const { return size() == 0; }
+
+    [[nodiscard]] static constexpr size_type capacity() { return _capacity; }
+
+private:
+    [[nodiscard]] T *_slot(size_type i) {
+        return m_slots.value + (i & (_capacity - 1));
+    }
+};
+} // namespace lmj
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <ranges>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace lmj {
+/**
+ * immutable sorted table over a fixed set of keys, stored in Eytzinger (breadth first) order so a lookup is a
+ * branchless descent of an implicit binary tree that prefetches the cache line of its descendants a few levels ahead
+ * @note unlike the hash tables it keeps the key order, so lower_bound, upper_bound and range queries work
+ * @note build with make_static_flat_table, a constexpr table of literal keys and values is emitted into .rodata
+ * @note slot 0 is unused, the root is slot 1 and the children of slot k are 2k and 2k + 1
+ */
+template<class key_tp, class value_tp, std::size_t _size, class compare_type = std::less<key_tp>>
+class static_flat_table {
+public:
+    static_assert(_size && "a table without keys is not allowed");
+    using key_type = key_tp;
+    using mapped_type = value_tp;
+    using pair_type = std::pair<key_tp, value_tp>;
+    using size_type = std::size_t;
+
+    /**
+     * visits the keys in ascending order, dereferences to a pair of references
+     */
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<key_tp const &, value_tp const &>;
+        using reference = value_type;
+        using difference_type = std::ptrdiff_t;
+
+        constexpr const_iterator() = default;
+
+        constexpr const_iterator(static_flat_table const *table, size_type index) : m_table{table}, m_index{index} {}
+
+        constexpr const_iterator &operator++() {
+            m_index = _successor(m_index);
+            return *this;
+        }
+
+        constexpr const_iterator operator++(int) {
+            const_iterator copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        [[nodiscard]] constexpr reference operator*() const { return {key(), value()}; }
+
+        [[nodiscard]] constexpr key_tp const &key() const { return m_table->m_keys[m_index]; }
+
+        [[nodiscard]] constexpr value_tp const &value() const { return m_table->m_values[m_index]; }
+
+        [[nodiscard]] constexpr bool operator==(const_iterator const &other) const { return m_index == other.m_index; }
+
+        /**
+         * @return slot of the element in Eytzinger order, 0 for end
+         */
+        [[nodiscard]] constexpr size_type index() const { return m_index; }
+
+    private:
+        static_flat_table const *m_table = nullptr;
+        size_type m_index = 0;
+    };
+
+    using iterator = const_iterator;
+
+    key_tp m_keys[_size + 1]{};
+    value_tp m_values[_size + 1]{};
+    compare_type m_compare{};
+
+    constexpr static_flat_table() = default;
+
+    /**
+     * @brief sorts pairs and lays them out in Eytzinger order, fails if keys aren't unique
+     */
+    constexpr explicit static_flat_table(std::array<pair_type, _size> pairs, compare_type compare = {})
+            : m_compare{compare} {
+        std::sort(pairs.begin(), pairs.end(),
+                  [&](pair_type const &a, pair_type const &b) { return m_compare(a.first, b.first); });
+        for (size_type i = 1; i < _size; ++i)
+            if (!m_compare(pairs[i - 1].first, pairs[i].first))
+                throw std::invalid_argument("duplicate key in static_flat_table");
+        size_type next = 0;
+        _fill(pairs, next, 1);
+    }
+
+    /**
+     * @return iterator to the first key not less than key
+     */
+    [[nodiscard]] constexpr const_iterator lower_bound(key_tp const &key) const {
+        return {this, _descend([&](key_tp const &k) { return m_compare(k, key); })};
+    }
+
+    /**
+     * @return iterator to the first key greater than key
+     */
+    [[nodiscard]] constexpr const_iterator upper_bound(key_tp const &key) const {
+        return {this, _descend([&](key_tp const &k) { return !m_compare(key, k); })};
+    }
+
+    /**
+     * @return the elements with keys in [first, last)
+     */
+    [[nodiscard]] constexpr std::ranges::subrange<const_iterator> range(key_tp const &first, key_tp const &last) const {
+        return {lower_bound(first), lower_bound(last)};
+    }
+
+    [[nodiscard]] constexpr const_iterator find(key_tp const &key) const {
+        const const_iterator it = lower_bound(key);
+        return it != end() && !m_compare(key, it.key()) ? it : end();
+    }
+
+    [[nodiscard]] constexpr bool contains(key_tp const &key) const {
+        return find(key) != end();
+    }
+
+    /**
+     * @return value at key or fails
+     */
+    [[nodiscard]] constexpr value_tp const &at(key_tp const &key) const {
+        const const_iterator it = find(key);
+        assert(it != end() && "key not found");
+        return it.value();
+    }
+
+    [[nodiscard]] constexpr const_iterator begin() const {
+        size_type k = 1;
+        while (2 * k <= _size)
+            k *= 2;
+        return {this, k};
+    }
+
+    [[nodiscard]] constexpr const_iterator end() const { return {this, 0}; }
+
+    [[nodiscard]] constexpr const_iterator cbegin() const { return begin(); }
+
+    [[nodiscard]] constexpr const_iterator cend() const { return end(); }
+
+    [[nodiscard]] constexpr size_type size() const { return _size; }
+
+    [[nodiscard]] constexpr bool empty() const { return false; }
+
+private:
+    /**
+     * @brief writes sorted[next, ...) to the subtree rooted at slot k in order
+     */
+    constexpr void _fill(std::array<pair_type, _size> const &sorted, size_type &next, size_type k) {
+        if (k > _size)
+            return;
+        _fill(sorted, next, 2 * k);
+        m_keys[k] = sorted[next].first;
+        m_values[k] = sorted[next].second;
+        ++next;
+        _fill(sorted, next, 2 * k + 1);
+    }
+
+    /**
+     * @return slot of the first key for which go_right is false, 0 if there is none
+     */
+    template<class F>
+    [[nodiscard]] constexpr size_type _descend(F go_right) const {
+        // keys per cache line, the descendants of k that many levels down are contiguous from k * block
+        constexpr size_type block = std::max<size_type>(1, 64 / sizeof(key_tp));
+        size_type k = 1;
+        while (k <= _size) {
+#if defined(__GNUC__) || defined(__clang__)
+            if (!std::is_constant_evaluated())
+                __builtin_prefetch(m_keys + std::min(k * block, _size));
+#endif
+            k = 2 * k + static_cast<size_type>(go_right(m_keys[k]));
+        }
+        // undo the right turns taken after the last left turn, and that left turn
+        return k >> (std::countr_one(k) + 1);
+    }
+
+    [[nodiscard]] static constexpr size_type _successor(size_type k) {
+        if (2 * k + 1 <= _size) {
+            k = 2 * k + 1;
+            while (2 * k <= _size)
+                k *= 2;
+            return k;
+        }
+        return k >> (std::countr_one(k) + 1);
+    }
+};
+
+/**
+ * @brief builds a static_flat_table over pairs, assign to a constexpr variable to do it at compile time
+ */
+template<class key_tp, class value_tp, std::size_t n, class compare_type = std::less<key_tp>>
+constexpr auto make_static_flat_table(std::array<std::pair<key_tp, value_tp>, n> const &pairs,
+                                      compare_type compare = {}) {
+    return static_flat_table<key_tp, value_tp, n, compare_type>{pairs, compare};
+}
+
+// tests
+static_assert(std::forward_iterator<static_flat_table<int, int, 4>::const_iterator>);
+static_assert([] {
+    constexpr auto table = make_static_flat_table(std::array{
+            std::pair{50, 'e'}, std::pair{10, 'a'}, std::pair{40, 'd'}, std::pair{20, 'b'}, std::pair{30, 'c'},
+            std::pair{60, 'f'}});
+    if (table.at(10) != 'a' || table.at(60) != 'f' || table.contains(35) || table.find(0) != table.end())
+        return false;
+    if (table.lower_bound(25).value() != 'c' || table.upper_bound(30).value() != 'd' ||
+        table.lower_bound(61) != table.end())
+        return false;
+    char expected = 'b';
+    for (auto [key, value]: table.range(15, 50))
+        if (value != expected++ || key != (value - 'a' + 1) * 10)
+            return false;
+    return expected == 'e' && std::ranges::distance(table.begin(), table.end()) == 6;
+}());
+} // namespace lmj
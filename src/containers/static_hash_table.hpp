@@ -1,7 +1,12 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cassert>
 #include <cstdint>
 #include <functional>
+#include <memory>
+#include <string_view>
 #include <utility>
 
 #include "container_helpers.hpp"
@@ -14,36 +19,59 @@ struct hash {
     }
 };
 
-template<class key_t, class value_t, std::size_t _capacity, class hash_t>
+/**
+ * fnv-1a, usable in constant evaluation unlike std::hash<std::string_view>
+ */
+template<>
+struct hash<std::string_view> {
+    constexpr std::uint64_t operator()(std::string_view s) const {
+        std::uint64_t result = 0xcbf29ce484222325ULL;
+        for (char c: s) {
+            result ^= static_cast<unsigned char>(c);
+            result *= 0x100000001b3ULL;
+        }
+        return result;
+    }
+};
+
+template<class key_t, class value_t, std::size_t _capacity, class hash_t, class generation_t>
 class static_hash_table_iterator;
 
-template<class key_t, class value_t, std::size_t _capacity, class hash_t>
+template<class key_t, class value_t, std::size_t _capacity, class hash_t, class generation_t>
 class static_hash_table_const_iterator;
 
-template<class key_tp, class value_tp, std::size_t _capacity, class hash_type = lmj::hash<key_tp>>
+/**
+ * @tparam generation_type void or an unsigned integer, if it is an integer control words are that wide and record
+ * the epoch they were written in, then clear() only starts a new epoch instead of touching every slot
+ */
+template<class key_tp, class value_tp, std::size_t _capacity, class hash_type = lmj::hash<key_tp>,
+         class generation_type = void>
 class static_hash_table {
+    using internal_size_type = detail::required_uint_t<_capacity>;
+public:
     enum active_enum {
         INACTIVE = 0,
         ACTIVE = 1,
         TOMBSTONE = 2,
     };
 
-    using internal_size_type = detail::required_uint_t<_capacity>;
-public:
     static_assert(_capacity && "a table with a capacity of zero is not allowed");
+    using key_type = key_tp;
+    using mapped_type = value_tp;
     using pair_type = std::pair<key_tp, value_tp>;
     using value_type = pair_type;
     using reference = value_type &;
     using const_reference = const value_type &;
     using size_type = std::size_t;
     using difference_type = std::make_signed_t<std::size_t>;
-    using bool_type = std::uint8_t;
-    using iterator = static_hash_table_iterator<key_tp, value_tp, _capacity, hash_type>;
-    using const_iterator = static_hash_table_const_iterator<key_tp, value_tp, _capacity, hash_type>;
-    pair_type m_table[_capacity]{};
+    using bool_type = typename detail::slot_states<generation_type>::word_type;
+    using iterator = static_hash_table_iterator<key_tp, value_tp, _capacity, hash_type, generation_type>;
+    using const_iterator = static_hash_table_const_iterator<key_tp, value_tp, _capacity, hash_type, generation_type>;
+    detail::uninitialized<pair_type> m_table[_capacity];
     bool_type m_is_set[_capacity]{};
     internal_size_type m_elem_count{};
     hash_type m_hasher{};
+    detail::slot_states<generation_type> m_states{};
 
     constexpr static_hash_table() = default;
 
@@ -53,9 +81,13 @@ public:
 
     constexpr static_hash_table(static_hash_table const &other) { *this = other; }
 
+    constexpr static_hash_table(static_hash_table &&other) noexcept { *this = std::move(other); }
+
     constexpr explicit static_hash_table(hash_type hasher) : m_hasher{hasher} {}
 
-    ~static_hash_table() = default;
+    constexpr ~static_hash_table() requires std::is_trivially_destructible_v<pair_type> = default;
+
+    constexpr ~static_hash_table() { clear(); }
 
     constexpr static_hash_table &operator=(static_hash_table const &other) {
         if (this != &other)
@@ -63,13 +95,19 @@ public:
         return *this;
     }
 
+    constexpr static_hash_table &operator=(static_hash_table &&other) noexcept {
+        if (this != &other)
+            _copy(std::move(other));
+        return *this;
+    }
+
     constexpr bool operator==(static_hash_table const &other) const {
         if (other.size() != this->size())
             return false;
         for (internal_size_type i = 0; i < _capacity; ++i) {
-            if (m_is_set[i] == ACTIVE &&
-                other.contains(m_table[i].first) &&
-                other.at(m_table[i].first) != m_table[i].second) {
+            if (_is_active(i) &&
+                other.contains(m_table[i].value.first) &&
+                other.at(m_table[i].value.first) != m_table[i].value.second) {
                 return false;
             }
         }
@@ -88,8 +126,8 @@ public:
      */
     [[nodiscard]] constexpr value_tp const &at(key_tp const &key) const {
         const internal_size_type idx = _get_index_read(key);
-        assert(m_is_set[idx] == ACTIVE && m_table[idx].first == key && "key not found");
-        return m_table[idx].second;
+        assert(_is_active(idx) && m_table[idx].value.first == key && "key not found");
+        return m_table[idx].value.second;
     }
 
     /**
@@ -97,8 +135,8 @@ public:
      */
     [[nodiscard]] constexpr value_tp &at(key_tp const &key) {
         const internal_size_type idx = _get_index_read(key);
-        assert(m_is_set[idx] == ACTIVE && m_table[idx].first == key && "key not found");
-        return m_table[idx].second;
+        assert(_is_active(idx) && m_table[idx].value.first == key && "key not found");
+        return m_table[idx].value.second;
     }
 
     /**
@@ -109,7 +147,7 @@ public:
         if (!m_elem_count)
             return emplace(key, value_tp{});
         const internal_size_type idx = _get_index_read(key);
-        return (m_is_set[idx] == ACTIVE && m_table[idx].first == key) ? m_table[idx].second : emplace(key, value_tp{});
+        return (_is_active(idx) && m_table[idx].value.first == key) ? m_table[idx].value.second : emplace(key, value_tp{});
     }
 
     /**
@@ -117,7 +155,7 @@ public:
      */
     constexpr bool contains(key_tp const &key) const {
         const internal_size_type idx = _get_index_read(key);
-        return m_is_set[idx] == ACTIVE && m_table[idx].first == key;
+        return _is_active(idx) && m_table[idx].value.first == key;
     }
 
     /**
@@ -132,11 +170,10 @@ public:
      */
     constexpr void remove(key_tp const &key) {
         const internal_size_type idx = _get_index_read(key);
-        if (m_is_set[idx] == ACTIVE && m_table[idx].first == key) {
+        if (_is_active(idx) && m_table[idx].value.first == key) {
             --m_elem_count;
-            m_table[idx].first = key_tp{};
-            m_table[idx].second = value_tp{};
-            m_is_set[idx] = TOMBSTONE;
+            std::destroy_at(&m_table[idx].value);
+            _set_state(idx, TOMBSTONE);
         }
     }
 
@@ -179,13 +216,13 @@ public:
         auto p = pair_type{std::forward<Args>(pack)...};
         const internal_size_type hash = _get_hash(p.first);
         internal_size_type idx = _get_index_read(p.first, hash);
-        if (m_is_set[idx] == ACTIVE && m_table[idx].first == p.first)
-            return m_table[idx].second;
+        if (_is_active(idx) && m_table[idx].value.first == p.first)
+            return m_table[idx].value.second;
         idx = _get_writable_index(p.first, hash);
         ++m_elem_count;
-        m_is_set[idx] = ACTIVE;
-        m_table[idx] = std::move(p);
-        return m_table[idx].second;
+        _set_state(idx, ACTIVE);
+        std::construct_at(&m_table[idx].value, std::move(p));
+        return m_table[idx].value.second;
     }
 
     /**
@@ -211,14 +248,15 @@ public:
 
     /**
      * @brief remove all elements
+     * @note O(1) with a generation_type if elements are trivially destructible
      */
     constexpr void clear() {
-        for (internal_size_type i = 0; i < _capacity; ++i) {
-            if (m_is_set[i] == ACTIVE) {
-                m_table[i].~pair_type();
-            }
-            m_is_set[i] = INACTIVE;
-        }
+        if constexpr (!std::is_trivially_destructible_v<pair_type>)
+            for (internal_size_type i = 0; m_elem_count && i < _capacity; ++i)
+                if (_is_active(i))
+                    std::destroy_at(&m_table[i].value);
+        if (!m_states.generational || m_states.next_epoch())
+            std::fill(m_is_set, m_is_set + _capacity, bool_type{});
         m_elem_count = 0;
     }
 
@@ -226,7 +264,7 @@ public:
         if (!m_elem_count)
             return end();
         const internal_size_type idx = _get_index_read(key);
-        if (m_is_set[idx] == ACTIVE && m_table[idx].first == key)
+        if (_is_active(idx) && m_table[idx].value.first == key)
             return const_iterator(this, idx);
         return end();
     }
@@ -235,28 +273,72 @@ public:
         return m_elem_count == 0;
     }
 
+    [[nodiscard]] constexpr bool _is_active(size_type idx) const { return m_is_set[idx] == m_states.tag(ACTIVE); }
+
+    [[nodiscard]] constexpr bool _is_tombstone(size_type idx) const { return m_is_set[idx] == m_states.tag(TOMBSTONE); }
+
+    constexpr void _set_state(size_type idx, active_enum state) { m_is_set[idx] = m_states.tag(state); }
+
+    /**
+     * @return storage of slot idx, it only holds a constructed pair while the slot is active
+     */
+    [[nodiscard]] constexpr pair_type &_slot(size_type idx) { return m_table[idx].value; }
+
+    [[nodiscard]] constexpr pair_type const &_slot(size_type idx) const { return m_table[idx].value; }
+
+    // relaxed atomic versions of the state and size accessors, for a writer that seqlock readers race with
+
+    [[nodiscard]] bool_type _load_state_relaxed(size_type idx) const {
+        return std::atomic_ref{const_cast<bool_type &>(m_is_set[idx])}.load(std::memory_order_relaxed);
+    }
+
+    void _set_state_relaxed(size_type idx, active_enum state) {
+        std::atomic_ref{m_is_set[idx]}.store(m_states.tag(state), std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] size_type _size_relaxed() const {
+        return std::atomic_ref{const_cast<internal_size_type &>(m_elem_count)}.load(std::memory_order_relaxed);
+    }
+
+    void _set_size_relaxed(size_type size) {
+        std::atomic_ref{m_elem_count}.store(static_cast<internal_size_type>(size), std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] constexpr internal_size_type _get_hash(key_tp const &key) const {
+        const internal_size_type hash = m_hasher(key);
+        return _clamp_size(hash ^ (~hash >> 16) ^ (hash << 24));
+    }
+
 private:
     [[nodiscard]] constexpr size_type _get_start_index() const {
         if (!m_elem_count)
-            return 0;
+            return _get_end_index();
         for (internal_size_type i = 0; i < _capacity; ++i)
-            if (m_is_set[i] == ACTIVE)
+            if (_is_active(i))
                 return i;
-        return 0; // should be unreachable;
+        return _get_end_index(); // should be unreachable;
     }
 
     [[nodiscard]] constexpr size_type _get_end_index() const {
         return _capacity;
     }
 
-    constexpr void _copy(static_hash_table const &other) {
-        for (internal_size_type i = 0; i < other.capacity(); ++i) {
-            if (other.m_is_set[i] == ACTIVE) {
-                m_table[i].first = other.m_table[i].first;
-                m_table[i].second = other.m_table[i].second;
+    /**
+     * @brief copies or moves the active slots of other to the same indices, keeping its tombstones
+     */
+    template<class table_type>
+    constexpr void _copy(table_type &&other) {
+        clear();
+        for (internal_size_type i = 0; i < _capacity; ++i) {
+            if (other._is_active(i)) {
+                if constexpr (std::is_rvalue_reference_v<table_type &&>)
+                    std::construct_at(&m_table[i].value, std::move(other.m_table[i].value));
+                else
+                    std::construct_at(&m_table[i].value, other.m_table[i].value);
             }
-            m_is_set[i] = other.m_is_set[i];
         }
+        std::copy(other.m_is_set, other.m_is_set + _capacity, m_is_set);
+        m_states = other.m_states;
         m_elem_count = other.m_elem_count;
         if constexpr (std::is_copy_assignable_v<hash_type>)
             m_hasher = other.m_hasher;
@@ -269,11 +351,6 @@ private:
             return idx & (_capacity - 1);
     }
 
-    [[nodiscard]] constexpr internal_size_type _get_hash(key_tp const &key) const {
-        const internal_size_type hash = m_hasher(key);
-        return _clamp_size(hash ^ (~hash >> 16) ^ (hash << 24));
-    }
-
     [[nodiscard]] constexpr internal_size_type _new_idx(internal_size_type const idx) const {
         if (idx < _capacity - 1)
             return idx + 1;
@@ -291,7 +368,7 @@ private:
 
     [[nodiscard]] constexpr internal_size_type _get_index_read_impl(key_tp const &key, internal_size_type idx) const {
         std::size_t _iterations = 0;
-        while ((m_is_set[idx] == TOMBSTONE || (m_is_set[idx] == ACTIVE && m_table[idx].first != key)) &&
+        while ((_is_tombstone(idx) || (_is_active(idx) && m_table[idx].value.first != key)) &&
                _iterations++ < _capacity) {
             idx = _new_idx(idx);
         }
@@ -309,7 +386,7 @@ private:
     [[nodiscard]] constexpr internal_size_type
     _get_writable_index_impl(key_tp const &key, internal_size_type idx) const {
         [[maybe_unused]] std::size_t iterations = 0;
-        while (m_is_set[idx] == ACTIVE && m_table[idx].first != key) {
+        while (_is_active(idx) && m_table[idx].value.first != key) {
             assert(iterations++ < _capacity && "empty slot not found");
             idx = _new_idx(idx);
         }
@@ -317,15 +394,9 @@ private:
     }
 };
 
-template<class key_t, class value_t, std::size_t _capacity, class hash_t = lmj::hash<key_t>>
+template<class key_t, class value_t, std::size_t _capacity, class hash_t = lmj::hash<key_t>, class generation_t = void>
 class static_hash_table_iterator {
-    using hash_table_t = static_hash_table<key_t, value_t, _capacity, hash_t>;
-    enum active_enum {
-        INACTIVE = 0,
-        ACTIVE = 1,
-        TOMBSTONE = 2,
-    };
-
+    using hash_table_t = static_hash_table<key_t, value_t, _capacity, hash_t, generation_t>;
 public:
     using pair_type = std::pair<key_t, value_t>;
     using size_type = typename hash_table_t::size_type;
@@ -343,14 +414,14 @@ public:
 
     constexpr static_hash_table_iterator(static_hash_table_iterator const &) = default;
 
-    constexpr static_hash_table_iterator(static_hash_table<key_t, value_t, _capacity, hash_t> *ptr,
+    constexpr static_hash_table_iterator(static_hash_table<key_t, value_t, _capacity, hash_t, generation_t> *ptr,
                                          size_type idx) : m_table_ptr{ptr}, m_index{idx} {}
 
     constexpr static_hash_table_iterator &operator=(static_hash_table_iterator const &) = default;
 
     constexpr static_hash_table_iterator &operator++() {
         ++m_index;
-        while (m_index < m_table_ptr->capacity() && m_table_ptr->m_is_set[m_index] != ACTIVE)
+        while (m_index < m_table_ptr->capacity() && !m_table_ptr->_is_active(m_index))
             ++m_index;
         return *this;
     }
@@ -363,7 +434,7 @@ public:
 
     constexpr static_hash_table_iterator &operator--() {
         --m_index;
-        while (m_index > 0 && m_table_ptr->m_is_set[m_index] != ACTIVE)
+        while (m_index > 0 && !m_table_ptr->_is_active(m_index))
             --m_index;
         return *this;
     }
@@ -375,11 +446,11 @@ public:
     }
 
     constexpr reference operator*() const {
-        return m_table_ptr->m_table[m_index];
+        return m_table_ptr->m_table[m_index].value;
     }
 
     constexpr auto operator->() const {
-        return &m_table_ptr->m_table[m_index];
+        return &m_table_ptr->m_table[m_index].value;
     }
 
     template<class T>
@@ -389,19 +460,13 @@ public:
 
     template<class T>
     constexpr bool operator==(T other) const {
-        return m_index == other.m_index || m_table_ptr == other.m_table_ptr;
+        return m_index == other.m_index && m_table_ptr == other.m_table_ptr;
     }
 };
 
-template<class key_t, class value_t, std::size_t _capacity, class hash_t = lmj::hash<key_t>>
+template<class key_t, class value_t, std::size_t _capacity, class hash_t = lmj::hash<key_t>, class generation_t = void>
 class static_hash_table_const_iterator {
-    using hash_table_t = static_hash_table<key_t, value_t, _capacity, hash_t>;
-    enum active_enum {
-        INACTIVE = 0,
-        ACTIVE = 1,
-        TOMBSTONE = 2,
-    };
-
+    using hash_table_t = static_hash_table<key_t, value_t, _capacity, hash_t, generation_t>;
 public:
     using pair_type = std::pair<key_t, value_t>;
     using size_type = typename hash_table_t::size_type;
@@ -420,18 +485,18 @@ public:
     constexpr static_hash_table_const_iterator(static_hash_table_const_iterator const &) = default;
 
     constexpr static_hash_table_const_iterator(
-            static_hash_table_iterator<key_t, value_t, _capacity, hash_t> const &other) : m_table_ptr{
+            static_hash_table_iterator<key_t, value_t, _capacity, hash_t, generation_t> const &other) : m_table_ptr{
             other.m_table_ptr}, m_index{other.m_index} {}
 
     constexpr static_hash_table_const_iterator(
-            static_hash_table<key_t, value_t, _capacity, hash_t> const *ptr,
+            static_hash_table<key_t, value_t, _capacity, hash_t, generation_t> const *ptr,
             size_type idx) : m_table_ptr{ptr}, m_index{idx} {}
 
     constexpr static_hash_table_const_iterator &operator=(static_hash_table_const_iterator const &) = default;
 
     constexpr static_hash_table_const_iterator &operator++() {
         ++m_index;
-        while (m_index < m_table_ptr->capacity() && m_table_ptr->m_is_set[m_index] != ACTIVE)
+        while (m_index < m_table_ptr->capacity() && !m_table_ptr->_is_active(m_index))
             ++m_index;
         return *this;
     }
@@ -444,7 +509,7 @@ public:
 
     constexpr static_hash_table_const_iterator &operator--() {
         --m_index;
-        while (m_index > 0 && m_table_ptr->m_is_set[m_index] != ACTIVE)
+        while (m_index > 0 && !m_table_ptr->_is_active(m_index))
             --m_index;
         return *this;
     }
@@ -456,11 +521,11 @@ public:
     }
 
     constexpr reference operator*() const {
-        return m_table_ptr->m_table[m_index];
+        return m_table_ptr->m_table[m_index].value;
     }
 
     constexpr auto operator->() const {
-        return &m_table_ptr->m_table[m_index];
+        return &m_table_ptr->m_table[m_index].value;
     }
 
     template<class T>
@@ -470,7 +535,7 @@ public:
 
     template<class T>
     constexpr bool operator==(T other) const {
-        return m_index == other.m_index || m_table_ptr == other.m_table_ptr;
+        return m_index == other.m_index && m_table_ptr == other.m_table_ptr;
     }
 };
 
@@ -530,4 +595,42 @@ static_assert([] {
     }();
     return m.at(1) == 1;
 }());
+static_assert([] {
+    struct no_default {
+        int x;
+
+        constexpr explicit no_default(int v) : x{v} {}
+
+        constexpr bool operator==(no_default const &) const = default;
+    };
+    lmj::static_hash_table<int, no_default, 64> t;
+    for (int i = 0; i < 32; ++i)
+        t.emplace(i, no_default{i});
+    for (int i = 0; i < 32; i += 2)
+        t.erase(i);
+    auto copy = t;
+    auto moved = std::move(t);
+    int sum = 0;
+    for (auto &[key, value]: copy)
+        sum += value.x;
+    return copy == moved && copy.size() == 16 && sum == 16 * 16 && !copy.contains(0) && copy.at(31).x == 31;
+}());
+static_assert([] {
+    lmj::static_hash_table<int, int, 64, lmj::hash<int>, std::uint8_t> t;
+    for (int round = 0; round < 200; ++round) {
+        for (int i = 0; i < 8; ++i)
+            t[round + i] = i;
+        t.erase(round);
+        if (t.size() != 7 || t.contains(round) || t.at(round + 7) != 7 || t.contains(round - 1))
+            return false;
+        t.clear();
+        if (!t.empty() || t.begin() != t.end())
+            return false;
+    }
+    return true;
+}());
+static_assert([] {
+    lmj::static_hash_table<int, int, 16> t;
+    return t.begin() == t.end() && std::is_trivially_destructible_v<decltype(t)>;
+}());
 } // namespace lmj
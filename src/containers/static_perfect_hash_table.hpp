@@ -0,0 +1,196 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "container_helpers.hpp"
+#include "static_hash_table.hpp"
+
+namespace lmj {
+/**
+ * immutable table over a fixed set of keys using a minimal perfect hash, every slot holds exactly one key,
+ * so a lookup is one probe of the pilot array, one probe of the table and a single key compare
+ * @note keys are grouped into buckets and every bucket gets a pilot that displaces its keys into free slots
+ * (PTHash style), build with make_static_perfect_hash_table, in a constexpr context to build at compile time
+ */
+template<class key_tp, class value_tp, std::size_t _size, class hash_type = lmj::hash<key_tp>>
+class static_perfect_hash_table {
+public:
+    static_assert(_size && "a table without keys is not allowed");
+    static_assert(_size <= std::numeric_limits<std::uint32_t>::max(), "too many keys");
+    using key_type = key_tp;
+    using mapped_type = value_tp;
+    using pair_type = std::pair<key_tp, value_tp>;
+    using value_type = pair_type;
+    using size_type = std::size_t;
+    using pilot_type = std::uint32_t;
+    using const_iterator = pair_type const *;
+    using iterator = const_iterator;
+
+    static constexpr size_type bucket_count = (_size + 3) / 4;
+    static constexpr pilot_type max_pilot = 1 << 24;
+
+    pair_type m_table[_size]{};
+    pilot_type m_pilots[bucket_count]{};
+    hash_type m_hasher{};
+
+    constexpr static_perfect_hash_table() = default;
+
+    /**
+     * @brief finds a pilot for every bucket, fails if keys aren't unique
+     */
+    constexpr explicit static_perfect_hash_table(std::array<pair_type, _size> const &pairs, hash_type hasher = {})
+            : m_hasher{hasher} {
+        // scratch space is allocated rather than on the stack, so large tables can be built at runtime
+        std::vector<std::uint64_t> hashes(_size);
+        std::vector<size_type> bucket_sizes(bucket_count);
+        for (size_type i = 0; i < _size; ++i) {
+            hashes[i] = _get_hash(pairs[i].first);
+            ++bucket_sizes[_bucket(hashes[i])];
+        }
+
+        // counting sort of the keys by bucket, bucket b is by_bucket[offsets[b], offsets[b + 1])
+        std::vector<size_type> offsets(bucket_count + 1);
+        for (size_type b = 0; b < bucket_count; ++b)
+            offsets[b + 1] = offsets[b] + bucket_sizes[b];
+        std::vector<size_type> by_bucket(_size);
+        std::vector<size_type> cursors(bucket_count);
+        for (size_type i = 0; i < _size; ++i) {
+            const size_type b = _bucket(hashes[i]);
+            by_bucket[offsets[b] + cursors[b]++] = i;
+        }
+
+        // largest buckets first, while most slots are still free
+        std::vector<size_type> bucket_order(bucket_count);
+        for (size_type b = 0; b < bucket_count; ++b)
+            bucket_order[b] = b;
+        std::sort(bucket_order.begin(), bucket_order.end(),
+                  [&](size_type a, size_type b) { return bucket_sizes[a] > bucket_sizes[b]; });
+
+        std::vector<unsigned char> taken(_size);
+        std::vector<size_type> slots(_size);
+        for (size_type b: bucket_order) {
+            const size_type first = offsets[b], last = offsets[b + 1];
+            for (size_type i = first; i < last; ++i)
+                for (size_type j = first; j < i; ++j)
+                    if (pairs[by_bucket[i]].first == pairs[by_bucket[j]].first)
+                        throw std::invalid_argument("duplicate key in static_perfect_hash_table");
+            pilot_type pilot = 0;
+            while (!_try_pilot(pilot, hashes.data(), by_bucket.data() + first, by_bucket.data() + last, taken.data(),
+                               slots.data()))
+                if (++pilot == max_pilot)
+                    throw std::logic_error("no pilot found for static_perfect_hash_table bucket");
+            m_pilots[b] = pilot;
+            for (size_type i = first; i < last; ++i)
+                taken[slots[i - first]] = 1;
+            for (size_type i = first; i < last; ++i)
+                m_table[slots[i - first]] = pairs[by_bucket[i]];
+        }
+    }
+
+    /**
+     * @return index of the only slot key can be in
+     */
+    [[nodiscard]] constexpr size_type index_of(key_tp const &key) const {
+        const std::uint64_t hash = _get_hash(key);
+        return _slot(hash, m_pilots[_bucket(hash)]);
+    }
+
+    [[nodiscard]] constexpr const_iterator find(key_tp const &key) const {
+        pair_type const *p = m_table + index_of(key);
+        return p->first == key ? p : end();
+    }
+
+    [[nodiscard]] constexpr bool contains(key_tp const &key) const {
+        return m_table[index_of(key)].first == key;
+    }
+
+    /**
+     * @return value at key or fails
+     */
+    [[nodiscard]] constexpr value_tp const &at(key_tp const &key) const {
+        pair_type const &p = m_table[index_of(key)];
+        assert(p.first == key && "key not found");
+        return p.second;
+    }
+
+    [[nodiscard]] constexpr const_iterator begin() const { return m_table; }
+
+    [[nodiscard]] constexpr const_iterator end() const { return m_table + _size; }
+
+    [[nodiscard]] constexpr const_iterator cbegin() const { return begin(); }
+
+    [[nodiscard]] constexpr const_iterator cend() const { return end(); }
+
+    [[nodiscard]] constexpr size_type size() const { return _size; }
+
+    [[nodiscard]] constexpr bool empty() const { return false; }
+
+private:
+    [[nodiscard]] constexpr std::uint64_t _get_hash(key_tp const &key) const {
+        return detail::mix64(static_cast<std::uint64_t>(m_hasher(key)));
+    }
+
+    [[nodiscard]] static constexpr size_type _bucket(std::uint64_t hash) {
+        return static_cast<size_type>(((hash & 0xffffffff) * bucket_count) >> 32);
+    }
+
+    [[nodiscard]] static constexpr size_type _slot(std::uint64_t hash, pilot_type pilot) {
+        const std::uint64_t mixed = detail::mix64(hash ^ (pilot * 0x9e3779b97f4a7c15ULL));
+        return static_cast<size_type>(((mixed >> 32) * _size) >> 32);
+    }
+
+    /**
+     * @return whether pilot sends every key of [first, last) to a distinct free slot, written to slots
+     */
+    [[nodiscard]] static constexpr bool _try_pilot(pilot_type pilot, std::uint64_t const *hashes,
+                                                   size_type const *first, size_type const *last,
+                                                   unsigned char const *taken, size_type *slots) {
+        for (size_type i = 0; first + i != last; ++i) {
+            slots[i] = _slot(hashes[first[i]], pilot);
+            if (taken[slots[i]])
+                return false;
+            for (size_type j = 0; j < i; ++j)
+                if (slots[j] == slots[i])
+                    return false;
+        }
+        return true;
+    }
+};
+
+/**
+ * @brief builds a static_perfect_hash_table over pairs, call in a constexpr context to do it at compile time
+ */
+template<class key_tp, class value_tp, std::size_t n, class hash_type = lmj::hash<key_tp>>
+constexpr auto make_static_perfect_hash_table(std::array<std::pair<key_tp, value_tp>, n> const &pairs,
+                                              hash_type hasher = {}) {
+    return static_perfect_hash_table<key_tp, value_tp, n, hash_type>{pairs, hasher};
+}
+
+// tests
+static_assert([] {
+    constexpr auto table = make_static_perfect_hash_table(std::array{
+            std::pair{std::string_view{"if"}, 0}, std::pair{std::string_view{"else"}, 1},
+            std::pair{std::string_view{"for"}, 2}, std::pair{std::string_view{"while"}, 3},
+            std::pair{std::string_view{"return"}, 4}, std::pair{std::string_view{"break"}, 5}});
+    return table.at("if") == 0 && table.at("while") == 3 && table.at("return") == 4 &&
+           !table.contains("do") && table.find("iff") == table.end();
+}());
+static_assert([] {
+    std::array<std::pair<int, int>, 200> pairs{};
+    for (std::size_t i = 0; i < pairs.size(); ++i)
+        pairs[i] = {static_cast<int>(i) * 7919, static_cast<int>(i)};
+    const auto table = make_static_perfect_hash_table(pairs);
+    for (int i = 0; i < 200; ++i)
+        if (table.at(i * 7919) != i || table.contains(i * 7919 + 1))
+            return false;
+    return true;
+}());
+} // namespace lmj
@@ -0,0 +1,235 @@
+#pragma once
+
+#include <bit>
+#include <cassert>
+#include <compare>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "static_hash_table.hpp"
+#include "static_vector.hpp"
+
+namespace lmj {
+/**
+ * string of at most _capacity chars stored inline in a static_vector, it never allocates and is trivially copyable,
+ * so it is a cheap key for short symbols and identifiers, also in constant evaluation
+ * @note not null terminated, use view() or str() to pass it on
+ */
+template<std::size_t _capacity>
+class static_string {
+public:
+    using value_type = char;
+    using size_type = std::size_t;
+    using iterator = char *;
+    using const_iterator = char const *;
+
+    static constexpr size_type npos = std::string_view::npos;
+
+    static_vector<char, _capacity> m_chars;
+
+    constexpr static_string() = default;
+
+    /**
+     * @brief copies anything that converts to a std::string_view, like literals and std::string
+     */
+    template<class S>
+        requires std::is_convertible_v<S const &, std::string_view>
+    constexpr static_string(S const &s) {
+        append(s);
+    }
+
+    [[nodiscard]] constexpr std::string_view view() const {
+        return {m_chars.data(), m_chars.size()};
+    }
+
+    constexpr operator std::string_view() const {
+        return view();
+    }
+
+    [[nodiscard]] std::string str() const {
+        return std::string{view()};
+    }
+
+    [[nodiscard]] constexpr size_type size() const { return m_chars.size(); }
+
+    [[nodiscard]] constexpr size_type length() const { return m_chars.size(); }
+
+    [[nodiscard]] static constexpr size_type capacity() { return _capacity; }
+
+    [[nodiscard]] constexpr bool empty() const { return m_chars.empty(); }
+
+    [[nodiscard]] constexpr char *data() { return m_chars.data(); }
+
+    [[nodiscard]] constexpr char const *data() const { return m_chars.data(); }
+
+    [[nodiscard]] constexpr char &operator[](size_type idx) { return m_chars[idx]; }
+
+    [[nodiscard]] constexpr char const &operator[](size_type idx) const { return m_chars[idx]; }
+
+    [[nodiscard]] constexpr char front() const { return m_chars.front(); }
+
+    [[nodiscard]] constexpr char back() const { return m_chars.back(); }
+
+    [[nodiscard]] constexpr iterator begin() { return m_chars.begin(); }
+
+    [[nodiscard]] constexpr iterator end() { return m_chars.end(); }
+
+    [[nodiscard]] constexpr const_iterator begin() const { return m_chars.begin(); }
+
+    [[nodiscard]] constexpr const_iterator end() const { return m_chars.end(); }
+
+    constexpr static_string &append(std::string_view s) {
+        assert(size() + s.size() <= _capacity && "out of space in static_string");
+        m_chars.append_range(s);
+        return *this;
+    }
+
+    constexpr static_string &operator+=(std::string_view s) {
+        return append(s);
+    }
+
+    constexpr static_string &operator+=(char c) {
+        push_back(c);
+        return *this;
+    }
+
+    constexpr void push_back(char c) {
+        m_chars.push_back(c);
+    }
+
+    constexpr char pop_back() {
+        return m_chars.pop_back();
+    }
+
+    constexpr void resize(size_type n, char c = '\0') {
+        m_chars.resize(n, c);
+    }
+
+    constexpr void clear() {
+        m_chars.clear();
+    }
+
+    /**
+     * @return index of the first c at or after pos, or npos
+     * @note compares 16 chars at a time with SSE2
+     */
+    [[nodiscard]] constexpr size_type find(char c, size_type pos = 0) const {
+#if defined(__SSE2__)
+        if (!std::is_constant_evaluated()) {
+            const __m128i needle = _mm_set1_epi8(c);
+            // whole blocks may read past size() but never past the inline storage, the mask drops those chars
+            for (size_type i = pos; i < size(); i += 16) {
+                unsigned mask;
+                if (i + 16 <= _capacity) {
+                    const __m128i block = _mm_loadu_si128(reinterpret_cast<__m128i const *>(data() + i));
+                    mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, needle)));
+                } else {
+                    mask = 0;
+                    for (size_type j = i; j < size(); ++j)
+                        mask |= unsigned{data()[j] == c} << (j - i);
+                }
+                if (size() - i < 16)
+                    mask &= (1u << (size() - i)) - 1;
+                if (mask)
+                    return i + static_cast<size_type>(std::countr_zero(mask));
+            }
+            return npos;
+        }
+#endif
+        return view().find(c, pos);
+    }
+
+    /**
+     * @return index of the first occurrence of s at or after pos, or npos
+     */
+    [[nodiscard]] constexpr size_type find(std::string_view s, size_type pos = 0) const {
+        if (s.empty())
+            return pos <= size() ? pos : npos;
+        const std::string_view v = view();
+        for (size_type i = find(s.front(), pos); i != npos && i + s.size() <= size(); i = find(s.front(), i + 1))
+            if (v.substr(i, s.size()) == s)
+                return i;
+        return npos;
+    }
+
+    [[nodiscard]] constexpr bool contains(char c) const {
+        return find(c) != npos;
+    }
+
+    [[nodiscard]] constexpr bool contains(std::string_view s) const {
+        return find(s) != npos;
+    }
+
+    [[nodiscard]] constexpr bool starts_with(std::string_view s) const {
+        return view().starts_with(s);
+    }
+
+    [[nodiscard]] constexpr bool ends_with(std::string_view s) const {
+        return view().ends_with(s);
+    }
+
+    [[nodiscard]] constexpr int compare(std::string_view s) const {
+        return view().compare(s);
+    }
+
+    template<std::size_t other_capacity>
+    [[nodiscard]] constexpr bool operator==(static_string<other_capacity> const &other) const {
+        return view() == other.view();
+    }
+
+    [[nodiscard]] constexpr bool operator==(std::string_view s) const {
+        return view() == s;
+    }
+
+    template<std::size_t other_capacity>
+    [[nodiscard]] constexpr std::strong_ordering operator<=>(static_string<other_capacity> const &other) const {
+        return view() <=> other.view();
+    }
+
+    [[nodiscard]] constexpr std::strong_ordering operator<=>(std::string_view s) const {
+        return view() <=> s;
+    }
+};
+
+/**
+ * hashes like the std::string_view it views
+ */
+template<std::size_t _capacity>
+struct hash<static_string<_capacity>> {
+    constexpr std::uint64_t operator()(static_string<_capacity> const &s) const {
+        return hash<std::string_view>{}(s.view());
+    }
+};
+
+// tests
+static_assert(std::is_trivially_copyable_v<static_string<16>>);
+static_assert([] {
+    static_string<8> s = "AAPL";
+    s += '.';
+    s.append("O");
+    return s == "AAPL.O" && s.size() == 6 && s.find('.') == 4 && s.find("L.") == 3 && s.find('x') == s.npos &&
+           s < static_string<4>{"MSFT"} && s.starts_with("AA");
+}());
+static_assert([] {
+    static_hash_table<static_string<16>, int, 8> table;
+    table["ES"] = 1;
+    table["NQ"] = 2;
+    table[static_string<16>{"ES"}] += 10;
+    return table.at("ES") == 11 && table.at("NQ") == 2 && !table.contains("YM");
+}());
+} // namespace lmj
+
+template<std::size_t _capacity>
+struct std::hash<lmj::static_string<_capacity>> {
+    std::size_t operator()(lmj::static_string<_capacity> const &s) const {
+        return std::hash<std::string_view>{}(s.view());
+    }
+};
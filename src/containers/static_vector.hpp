@@ -1,12 +1,18 @@
 #pragma once
 
 #include "container_helpers.hpp"
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cstdint>
+#include <cstring>
+#include <initializer_list>
 #include <iterator>
 #include <limits>
+#include <memory>
 #include <numeric>
+#include <ranges>
+#include <string>
 #include <type_traits>
 #include <vector>
 
@@ -27,6 +33,10 @@ constexpr auto all_same_types() {
     return !sizeof...(Args) || (std::is_same_v<Args, first_type_t<Args...>> && ...);
 }
 
+/**
+ * vector with inline storage for up to _capacity elements, elements only exist between begin() and end()
+ * @note trivially copyable if T is, copies and erasures of trivially copyable elements are memcpy/memmove
+ */
 template<class T, std::size_t _capacity>
 class static_vector {
 private:
@@ -43,54 +53,78 @@ public:
     using reverse_iterator = std::reverse_iterator<iterator>;
     using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
-    value_type m_data[_capacity]{};
+    detail::uninitialized<value_type[_capacity]> m_data;
     size_type m_size{};
 
     constexpr static_vector() = default;
 
     constexpr explicit static_vector(size_type n) {
         assert(n <= _capacity);
-        m_size = n;
+        for (; m_size < n; ++m_size)
+            std::construct_at(data() + m_size);
     }
 
     constexpr explicit static_vector(size_type n, T const &value) {
-        m_size = n;
-        for (size_type i = 0; i < m_size; ++i)
-            m_data[i] = value;
+        assert(n <= _capacity);
+        for (; m_size < n; ++m_size)
+            std::construct_at(data() + m_size, value);
     }
 
-    template<class Iter>
+    template<std::input_iterator Iter>
     constexpr explicit static_vector(Iter begin, Iter end) {
-        static_assert(decltype(++begin, begin != end, *begin, 0)() == 0);
-        while (begin != end) {
-            emplace_back(*begin);
-            ++begin;
+        _append(begin, end);
+    }
+
+    constexpr static_vector(static_vector const &) requires std::is_trivially_copy_constructible_v<T> = default;
+
+    constexpr static_vector(static_vector const &other) { _copy_construct(other.begin(), other.size()); }
+
+    constexpr static_vector(static_vector &&) noexcept requires std::is_trivially_move_constructible_v<T> = default;
+
+    constexpr static_vector(static_vector &&other) noexcept {
+        for (; m_size < other.m_size; ++m_size)
+            std::construct_at(data() + m_size, std::move(other.data()[m_size]));
+    }
+
+    constexpr static_vector &operator=(static_vector const &) requires std::is_trivially_copy_assignable_v<T> = default;
+
+    constexpr static_vector &operator=(static_vector const &other) {
+        if (this != &other) {
+            clear();
+            _copy_construct(other.begin(), other.size());
         }
+        return *this;
     }
 
-    constexpr static_vector(static_vector const &) = default;
+    constexpr static_vector &operator=(static_vector &&) noexcept requires std::is_trivially_move_assignable_v<T> = default;
 
-    constexpr static_vector(static_vector &&) noexcept = default;
+    constexpr static_vector &operator=(static_vector &&other) noexcept {
+        if (this != &other) {
+            clear();
+            for (; m_size < other.m_size; ++m_size)
+                std::construct_at(data() + m_size, std::move(other.data()[m_size]));
+        }
+        return *this;
+    }
 
-    constexpr static_vector &operator=(static_vector const &) = default;
+    constexpr ~static_vector() requires std::is_trivially_destructible_v<T> = default;
 
-    constexpr static_vector &operator=(static_vector &&) noexcept = default;
+    constexpr ~static_vector() { clear(); }
 
     template<std::size_t other_capacity>
     constexpr auto &operator=(static_vector<T, other_capacity> const &other) {
-        assert(other.m_size <= _capacity);
-        m_size = other.m_size;
-        for (size_type i = 0; i < m_size; ++i)
-            m_data[i] = other.m_data[i];
+        assert(other.size() <= _capacity);
+        clear();
+        _copy_construct(other.begin(), other.size());
         return *this;
     }
 
     template<std::size_t other_capacity>
     constexpr auto &operator=(static_vector<T, other_capacity> &&other) {
-        assert(other.m_size <= _capacity);
-        m_size = other.m_size;
-        for (size_type i = 0; i < m_size; ++i)
-            m_data[i] = std::move(other.m_data[i]);
+        assert(other.size() <= _capacity);
+        clear();
+        for (; m_size < other.size(); ++m_size)
+            std::construct_at(data() + m_size, std::move(other[m_size]));
         return *this;
     }
 
@@ -106,9 +140,7 @@ public:
 
     constexpr static_vector(std::initializer_list<T> il) {
         assert(il.size() <= _capacity);
-        m_size = il.size();
-        for (size_type i = 0; i < m_size; ++i)
-            m_data[i] = il.begin()[i];
+        _copy_construct(il.begin(), il.size());
     }
 
     [[nodiscard]] constexpr size_type size() const {
@@ -123,6 +155,14 @@ public:
         return _capacity;
     }
 
+    [[nodiscard]] constexpr pointer data() {
+        return m_data.value;
+    }
+
+    [[nodiscard]] constexpr const_pointer data() const {
+        return m_data.value;
+    }
+
     template<class G>
     constexpr auto &push_back(G &&elem) {
         return emplace_back(std::forward<G>(elem));
@@ -131,73 +171,177 @@ public:
     template<class... Args>
     constexpr auto &emplace_back(Args &&...args) {
         assert(m_size < _capacity && "out of space in static_vector");
-        m_data[m_size++] = T(std::forward<Args>(args)...);
-        return m_data[m_size - 1];
+        std::construct_at(data() + m_size, std::forward<Args>(args)...);
+        return data()[m_size++];
     }
 
     [[nodiscard]] constexpr reference operator[](size_type idx) {
         assert(idx < m_size && "no element to return");
-        return m_data[idx];
+        return data()[idx];
     }
 
     [[nodiscard]] constexpr const_reference operator[](size_type idx) const {
         assert(idx < m_size && "no element to return");
-        return m_data[idx];
+        return data()[idx];
     }
 
     [[nodiscard]] constexpr reference front() {
         assert(m_size && "no element to return");
-        return m_data[0];
+        return data()[0];
     }
 
     [[nodiscard]] constexpr const_reference front() const {
         assert(m_size && "no element to return");
-        return m_data[0];
+        return data()[0];
     }
 
     [[nodiscard]] constexpr reference back() {
         assert(m_size && "no element to return");
-        return m_data[m_size - 1];
+        return data()[m_size - 1];
     }
 
     [[nodiscard]] constexpr const_reference back() const {
         assert(m_size && "no element to return");
-        return m_data[m_size - 1];
+        return data()[m_size - 1];
     }
 
     constexpr T pop_back() {
         assert(m_size && "no element to pop");
-        auto res = std::move(m_data[m_size - 1]);
-        m_data[--m_size].~T();
+        auto res = std::move(data()[m_size - 1]);
+        std::destroy_at(data() + --m_size);
         return res;
     }
 
+    /**
+     * @brief inserts copies of [first, last) before pos, which must not point into this vector
+     * @return iterator to the first inserted element
+     */
+    template<std::input_iterator Iter>
+    constexpr iterator insert(const_iterator pos, Iter first, Iter last) {
+        assert(pos >= begin() && pos <= end());
+        const auto offset = static_cast<size_type>(pos - begin());
+        if constexpr (std::is_trivially_copyable_v<T> && std::forward_iterator<Iter>) {
+            if (!std::is_constant_evaluated()) {
+                const auto count = static_cast<size_type>(std::distance(first, last));
+                assert(m_size + count <= _capacity && "out of space in static_vector");
+                T *gap = data() + offset;
+                std::memmove(gap + count, gap, (m_size - offset) * sizeof(T));
+                if constexpr (std::contiguous_iterator<Iter> && std::is_same_v<std::iter_value_t<Iter>, T>) {
+                    if (count)
+                        std::memcpy(gap, std::to_address(first), count * sizeof(T));
+                } else {
+                    std::copy(first, last, gap);
+                }
+                m_size += count;
+                return gap;
+            }
+        }
+        const size_type old_size = m_size;
+        _append(first, last);
+        std::rotate(begin() + offset, begin() + old_size, end());
+        return begin() + offset;
+    }
+
+    constexpr iterator insert(const_iterator pos, std::initializer_list<T> il) {
+        return insert(pos, il.begin(), il.end());
+    }
+
+    constexpr iterator insert(const_iterator pos, T const &value) {
+        return emplace(pos, value);
+    }
+
+    constexpr iterator insert(const_iterator pos, T &&value) {
+        return emplace(pos, std::move(value));
+    }
+
+    /**
+     * @brief constructs an element from args before pos
+     * @return iterator to the new element
+     */
+    template<class... Args>
+    constexpr iterator emplace(const_iterator pos, Args &&...args) {
+        assert(pos >= begin() && pos <= end());
+        const auto offset = pos - begin();
+        emplace_back(std::forward<Args>(args)...);
+        std::rotate(begin() + offset, end() - 1, end());
+        return begin() + offset;
+    }
+
+    /**
+     * @brief appends copies of the elements of range, memcpy if they are contiguous and trivially copyable
+     */
+    template<std::ranges::input_range R>
+    constexpr void append_range(R &&range) {
+        _append(std::ranges::begin(range), std::ranges::end(range));
+    }
+
+    /**
+     * @brief value initializes or destroys elements at the back until there are n
+     */
+    constexpr void resize(size_type n) {
+        assert(n <= _capacity && "out of space in static_vector");
+        if (n <= m_size) {
+            _destroy_from(n);
+            return;
+        }
+        for (; m_size < n; ++m_size)
+            std::construct_at(data() + m_size);
+    }
+
+    /**
+     * @brief copies value or destroys elements at the back until there are n
+     */
+    constexpr void resize(size_type n, T const &value) {
+        assert(n <= _capacity && "out of space in static_vector");
+        if (n <= m_size) {
+            _destroy_from(n);
+            return;
+        }
+        for (; m_size < n; ++m_size)
+            std::construct_at(data() + m_size, value);
+    }
+
+    template<std::input_iterator Iter>
+    constexpr void assign(Iter first, Iter last) {
+        clear();
+        _append(first, last);
+    }
+
+    constexpr void assign(size_type n, T const &value) {
+        clear();
+        resize(n, value);
+    }
+
+    constexpr void assign(std::initializer_list<T> il) {
+        clear();
+        _copy_construct(il.begin(), il.size());
+    }
+
     constexpr void erase(const_iterator iter) {
         erase(iter, iter + 1);
     }
 
     constexpr void erase(const_iterator first, const_iterator last) {
         assert(first >= begin() && first <= end());
-        assert(last >= begin() && (last <= end() || last == end()));
+        assert(last >= first && last <= end());
 
         if (first == last) return;
 
         iterator i1 = begin() + (first - begin()), i2 = begin() + (last - begin());
-        if (i1 != first || i2 != last)
-#if __has_builtin(__builtin_unreachable)
-            __builtin_unreachable()
-#endif
-                    ;
-
-        while (i2 != end())
-            *i1++ = *i2++;
-        m_size -= last - first;
+        const auto count = static_cast<size_type>(i2 - i1);
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            if (!std::is_constant_evaluated()) {
+                std::memmove(i1, i2, static_cast<size_type>(end() - i2) * sizeof(T));
+                m_size -= count;
+                return;
+            }
+        }
+        std::move(i2, end(), i1);
+        _destroy_from(m_size - count);
     }
 
     constexpr void clear() {
-        for (size_type i = 0; i < m_size; ++i)
-            m_data[i].~T();
-        m_size = 0;
+        _destroy_from(0);
     }
 
     [[nodiscard]] constexpr bool empty() const {
@@ -205,7 +349,7 @@ public:
     }
 
     [[nodiscard]] constexpr const_iterator begin() const {
-        return const_iterator{m_data};
+        return const_iterator{data()};
     }
 
     [[nodiscard]] constexpr const_iterator end() const {
@@ -213,7 +357,7 @@ public:
     }
 
     [[nodiscard]] constexpr iterator begin() {
-        return iterator{m_data};
+        return iterator{data()};
     }
 
     [[nodiscard]] constexpr iterator end() {
@@ -221,7 +365,7 @@ public:
     }
 
     [[nodiscard]] constexpr const_iterator cbegin() const {
-        return const_iterator{m_data};
+        return const_iterator{data()};
     }
 
     [[nodiscard]] constexpr const_iterator cend() const {
@@ -254,27 +398,64 @@ public:
 
     template<std::size_t other_capacity>
     [[nodiscard]] constexpr bool operator==(static_vector<T, other_capacity> const &other) const {
-        if (m_size != other.m_size)
+        if (m_size != other.size())
             return false;
         for (size_type i = 0; i < m_size; ++i)
-            if (m_data[i] != other.m_data[i])
+            if (data()[i] != other[i])
                 return false;
         return true;
     }
 
     template<std::size_t other_capacity>
     [[nodiscard]] constexpr bool operator!=(static_vector<T, other_capacity> const &other) const {
-        if (m_size != other.m_size)
-            return true;
-        for (size_type i = 0; i < m_size; ++i)
-            if (m_data[i] != other.m_data[i])
-                return false;
-        return true;
+        return !(*this == other);
     }
 
     [[nodiscard]] std::vector<T> to_std_vector() const {
         return std::vector(begin(), end());
     }
+
+private:
+    /**
+     * @brief copy constructs the elements of [first, last) after the current ones
+     */
+    template<class Iter, class Sentinel>
+    constexpr void _append(Iter first, Sentinel last) {
+        if constexpr (std::contiguous_iterator<Iter> && std::sized_sentinel_for<Sentinel, Iter> &&
+                      std::is_same_v<std::iter_value_t<Iter>, T>) {
+            const auto count = static_cast<size_type>(last - first);
+            assert(m_size + count <= _capacity && "out of space in static_vector");
+            _copy_construct(std::to_address(first), count);
+        } else {
+            for (; first != last; ++first)
+                emplace_back(*first);
+        }
+    }
+
+    /**
+     * @brief copy constructs count elements from src after the current ones
+     */
+    constexpr void _copy_construct(const_pointer src, size_type count) {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            if (!std::is_constant_evaluated()) {
+                if (count)
+                    std::memcpy(data() + m_size, src, count * sizeof(T));
+                m_size += count;
+                return;
+            }
+        }
+        for (size_type i = 0; i < count; ++i, ++m_size)
+            std::construct_at(data() + m_size, src[i]);
+    }
+
+    /**
+     * @brief destroys the elements from index new_size on
+     */
+    constexpr void _destroy_from(size_type new_size) {
+        if constexpr (!std::is_trivially_destructible_v<T>)
+            std::destroy(data() + new_size, data() + m_size);
+        m_size = new_size;
+    }
 };
 
 
@@ -313,4 +494,30 @@ static_assert([] {
     v1 = v2;
     return true;
 }());
+static_assert(std::is_trivially_copyable_v<static_vector<int, 8>>);
+static_assert([] {
+    static_vector<int, 16> v = {1, 5};
+    const std::array<int, 3> middle = {2, 3, 4};
+    v.insert(v.begin() + 1, middle.begin(), middle.end());
+    v.append_range(std::array{6, 7});
+    v.emplace(v.begin(), 0);
+    v.resize(10);
+    if (v != static_vector<int, 10>{0, 1, 2, 3, 4, 5, 6, 7, 0, 0})
+        return false;
+    v.assign(3, 9);
+    return v == static_vector<int, 3>{9, 9, 9};
+}());
+static_assert(!std::is_trivially_destructible_v<static_vector<std::string, 8>>);
+static_assert([] {
+    static_vector<std::string, 4> v(2, "abc");
+    v.emplace_back(3, 'd');
+    static_vector<std::string, 4> copy = v;
+    copy.erase(copy.begin());
+    v = std::move(copy);
+    v.pop_back();
+    const std::string extra[] = {"x", "y"};
+    v.insert(v.begin(), std::begin(extra), std::end(extra));
+    v.resize(4, "z");
+    return v == static_vector<std::string, 4>{"x", "y", "abc", "z"} && static_vector<std::string, 4>(3).back().empty();
+}());
 } // namespace lmj
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "hash_table.hpp"
+
+namespace lmj {
+/**
+ * maps strings to dense ids and back, string bytes are copied once into append only chunks
+ * so views and ids stay valid for the lifetime of the interner
+ */
+class string_interner {
+public:
+    using id_type = std::uint32_t;
+    using size_type = std::size_t;
+    static constexpr id_type npos = std::numeric_limits<id_type>::max();
+    static constexpr size_type default_chunk_size = 1 << 16;
+
+    std::vector<std::unique_ptr<char[]>> m_chunks;
+    char *m_cursor{};
+    size_type m_remaining{};
+    size_type m_chunk_size{};
+    size_type m_bytes{};
+    std::vector<std::string_view> m_strings;
+    hash_table<std::string_view, id_type> m_index;
+
+    explicit string_interner(size_type chunk_size = default_chunk_size) : m_chunk_size{chunk_size} {
+        assert(chunk_size && "chunk size must be positive");
+    }
+
+    string_interner(string_interner const &) = delete;
+
+    string_interner &operator=(string_interner const &) = delete;
+
+    string_interner(string_interner &&) noexcept = default;
+
+    string_interner &operator=(string_interner &&) noexcept = default;
+
+    /**
+     * @return id of s, assigning the next free id if s wasn't interned before
+     * @note doesn't allocate if s was already interned
+     */
+    id_type intern(std::string_view s) {
+        if (auto it = m_index.find(s); it != m_index.end())
+            return it->second;
+        assert(m_strings.size() < npos && "out of ids");
+        const auto id = static_cast<id_type>(m_strings.size());
+        const std::string_view stored = _store(s);
+        m_strings.push_back(stored);
+        m_index.emplace(stored, id);
+        return id;
+    }
+
+    /**
+     * @brief interns every string of [first, last)
+     * @param out receives the id of every string, in order
+     * @return out after the last written id
+     */
+    template<class Iter, class OutIter>
+    OutIter intern_many(Iter first, Iter last, OutIter out) {
+        for (; first != last; ++first)
+            *out++ = intern(std::string_view{*first});
+        return out;
+    }
+
+    /**
+     * @return id of s or npos if it was never interned
+     */
+    [[nodiscard]] id_type find(std::string_view s) const {
+        const auto it = m_index.find(s);
+        return it == m_index.end() ? npos : it->second;
+    }
+
+    [[nodiscard]] bool contains(std::string_view s) const {
+        return m_index.contains(s);
+    }
+
+    /**
+     * @return string with the given id
+     */
+    [[nodiscard]] std::string_view operator[](id_type id) const {
+        assert(id < m_strings.size() && "unknown id");
+        return m_strings[id];
+    }
+
+    /**
+     * @return number of distinct strings
+     */
+    [[nodiscard]] size_type size() const { return m_strings.size(); }
+
+    [[nodiscard]] bool empty() const { return m_strings.empty(); }
+
+    /**
+     * @return total length of all interned strings
+     */
+    [[nodiscard]] size_type string_bytes() const { return m_bytes; }
+
+private:
+    std::string_view _store(std::string_view s) {
+        if (s.empty())
+            return {};
+        if (s.size() > m_remaining) {
+            const size_type size = std::max(s.size(), m_chunk_size);
+            m_chunks.push_back(std::make_unique_for_overwrite<char[]>(size));
+            m_cursor = m_chunks.back().get();
+            m_remaining = size;
+        }
+        std::memcpy(m_cursor, s.data(), s.size());
+        const std::string_view stored{m_cursor, s.size()};
+        m_cursor += s.size();
+        m_remaining -= s.size();
+        m_bytes += s.size();
+        return stored;
+    }
+};
+} // namespace lmj
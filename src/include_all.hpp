@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include "algorithms/algorithms.hpp"
 #include "containers/containers.hpp"
 #include "io/io.hpp"
 #include "math/math.hpp"
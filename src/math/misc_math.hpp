@@ -4,6 +4,7 @@
 #include "../utils/concepts.hpp"
 #include "newton_raphson.hpp"
 
+#include <bit>
 #include <cassert>
 #include <cmath>
 #include <ranges>
@@ -106,12 +107,17 @@ constexpr long double exp(long double x) {
  * @return floor(log2(x))
  */
 constexpr auto flog2(integral auto x) {
+    using T = std::remove_cvref_t<decltype(x)>;
     if (x <= 0)
         return std::numeric_limits<int>::min();
-    int ans = 0;
-    while (x >>= 1)
-        ++ans;
-    return ans;
+    if constexpr (std::is_integral_v<T>) {
+        return static_cast<int>(std::bit_width(static_cast<std::make_unsigned_t<T>>(x))) - 1;
+    } else { // 128 bit integers
+        int ans = 0;
+        while (x >>= 1)
+            ++ans;
+        return ans;
+    }
 }
 
 /**
@@ -3,6 +3,9 @@
 #include <cmath>
 #include <future>
 #include <iomanip>
+#include <list>
+#include <map>
+#include <optional>
 #include <set>
 #include <string>
 
@@ -30,6 +33,7 @@ concept Container = requires(ContainerType a, const ContainerType b) {
 };
 
 static_assert(Container<lmj::static_vector<int, 1>>);
+static_assert(Container<lmj::small_vector<int, 1>>);
 static_assert(Container<lmj::static_hash_table<int, int, 1>>);
 static_assert(Container<lmj::hash_table<int, int>>);
 
@@ -205,7 +209,7 @@ int main() {
             assert(m.find(i) != m.end());
             assert(m.find(i)->first == i);
         }
-        assert(m.find(1024) == m.end());
+        assert(m.find(n) == m.end());
     });
     register_test([] {
         constexpr int n = 1 << 14;
@@ -224,6 +228,1053 @@ int main() {
         assert(m1 == m2);
         assert(m1.find(n) == m1.end());
     });
+    register_test([] {
+        constexpr int n = 1 << 18;
+        // compare lmj::lru_cache against std::list + std::unordered_map
+        constexpr std::size_t capacity = 512;
+        std::size_t evicted = 0;
+        auto on_evict = [&](int const &, int &) { ++evicted; };
+        lmj::lru_cache<int, int, std::hash<int>, decltype(on_evict)> cache{capacity, on_evict};
+        const auto index_capacity = cache.m_index.capacity();
+        std::list<std::pair<int, int>> order;
+        std::unordered_map<int, std::list<std::pair<int, int>>::iterator> check;
+        std::size_t hits = 0, misses = 0, check_evicted = 0;
+        for (int i = 0; i < n; ++i) {
+            const int key = lmj::randint(0, 2048);
+            switch (lmj::randint(0, 3)) {
+                case 0: {
+                    int *res = cache.find(key);
+                    auto it = check.find(key);
+                    assert((res == nullptr) == (it == check.end()));
+                    if (it != check.end()) {
+                        ++hits;
+                        assert(*res == it->second->second);
+                        order.splice(order.begin(), order, it->second);
+                    } else {
+                        ++misses;
+                    }
+                    break;
+                }
+                case 1:
+                    assert(cache.erase(key) == (check.erase(key) > 0));
+                    if (auto it = std::find_if(order.begin(), order.end(), [&](auto &p) { return p.first == key; }); it != order.end())
+                        order.erase(it);
+                    break;
+                default: {
+                    cache.insert(key, i);
+                    if (auto it = check.find(key); it != check.end()) {
+                        it->second->second = i;
+                        order.splice(order.begin(), order, it->second);
+                    } else {
+                        if (order.size() == capacity) {
+                            check.erase(order.back().first);
+                            order.pop_back();
+                            ++check_evicted;
+                        }
+                        order.emplace_front(key, i);
+                        check[key] = order.begin();
+                    }
+                }
+            }
+            assert(cache.size() == check.size());
+        }
+        for (auto &[key, val]: order)
+            assert(*cache.peek(key) == val);
+        assert(cache.hits() == hits && cache.misses() == misses);
+        assert(cache.evictions() == check_evicted && evicted == check_evicted);
+        assert(cache.m_index.capacity() == index_capacity);
+    });
+    register_test([] {
+        constexpr int n = 1 << 18;
+        // test lmj::clock_cache keeps frequently used keys and never outgrows its index
+        constexpr std::size_t capacity = 256;
+        lmj::clock_cache<int, int> cache{capacity};
+        const auto index_capacity = cache.m_index.capacity();
+        for (int i = 0; i < 16; ++i)
+            cache.insert(-1 - i, i);
+        for (int i = 0; i < n; ++i) {
+            for (int j = 0; j < 16; ++j)
+                assert(cache.find(-1 - j) && *cache.find(-1 - j) == j);
+            cache.insert(i, i);
+            if (i % 7 == 0 && i >= 3)
+                cache.erase(i - 3);
+            assert(cache.size() <= capacity);
+        }
+        assert(cache.contains(n - 1) && !cache.contains(0));
+        assert(cache.hits() == 2ull * 16 * n && cache.misses() == 0);
+        assert(cache.m_index.capacity() == index_capacity);
+        cache.clear();
+        assert(cache.empty() && !cache.contains(n - 1));
+    });
+    register_test([] {
+        // test lmj::lru_cache and lmj::clock_cache release values on erase, eviction and clear,
+        // and hold values that aren't default constructible
+        struct handle {
+            std::shared_ptr<int> ptr;
+
+            explicit handle(std::shared_ptr<int> p) : ptr{std::move(p)} {}
+        };
+        const auto check_cache = [](auto cache) {
+            const auto ptr = std::make_shared<int>(0);
+            cache.insert(0, handle{ptr});
+            cache.insert(1, handle{ptr});
+            assert(ptr.use_count() == 3);
+            assert(cache.erase(0) && !cache.erase(0));
+            assert(ptr.use_count() == 2);
+            cache.insert(2, handle{ptr});
+            cache.insert(3, handle{nullptr});
+            cache.insert(4, handle{nullptr});
+            cache.insert(5, handle{nullptr});
+            assert(ptr.use_count() == 1 && cache.evictions() == 2);
+            cache.insert(6, handle{ptr});
+            auto moved = std::move(cache);
+            assert(ptr.use_count() == 2 && moved.peek(6)->ptr == ptr);
+            moved.clear();
+            assert(ptr.use_count() == 1 && moved.empty());
+            moved.insert(7, handle{ptr});
+            return ptr;
+        };
+        assert(check_cache(lmj::lru_cache<int, handle>{3}).use_count() == 1);
+        assert(check_cache(lmj::clock_cache<int, handle>{3}).use_count() == 1);
+    });
+    register_test([] {
+        constexpr int n = 1 << 18;
+        // test lmj::bloom_filter has no false negatives and roughly the requested false positive rate
+        lmj::bloom_filter<int> filter{n, 0.01};
+        std::vector<int> keys(n);
+        for (int i = 0; i < n; ++i)
+            keys[i] = i * 2;
+        filter.add_many(keys.begin(), keys.end());
+        std::vector<char> found(n);
+        filter.maybe_contains_many(keys.begin(), keys.end(), found.begin());
+        for (int i = 0; i < n; ++i)
+            assert(found[i] && filter.maybe_contains(keys[i]));
+        int false_positives = 0;
+        for (int i = 0; i < n; ++i)
+            false_positives += filter.maybe_contains(i * 2 + 1);
+        assert(false_positives < n / 50);
+        assert(filter.false_positive_rate(n) <= 0.01);
+    });
+    register_test([] {
+        constexpr int n = 1 << 16;
+        // test lmj::bloom_filtered in front of lmj::hash_table agrees with the table
+        lmj::bloom_filtered<lmj::hash_table<int, int>> map{n};
+        for (int i = 0; i < n; ++i)
+            map[i * 3] = i;
+        for (int i = 0; i < n; i += 2)
+            map.erase(i * 3);
+        map.rebuild_filter();
+        std::vector<int> keys(3 * n);
+        std::iota(keys.begin(), keys.end(), 0);
+        std::vector<char> found(keys.size());
+        map.contains_many(keys.begin(), keys.end(), found.begin());
+        for (int key: keys) {
+            const bool expected = key % 3 == 0 && (key / 3) % 2 == 1;
+            assert(map.contains(key) == expected && bool(found[key]) == expected);
+            assert((map.find(key) != map.end()) == expected);
+        }
+        assert(map.size() == n / 2);
+    });
+    register_test([] {
+        constexpr int n = 1 << 18;
+        // test lmj::aggregate counts and sums like a single std::unordered_map
+        std::vector<std::pair<int, std::uint64_t>> rows(n);
+        for (auto &[key, val]: rows)
+            key = lmj::randint(0, 1 << 12), val = lmj::rand<std::uint32_t>();
+        std::unordered_map<int, std::pair<std::uint64_t, std::uint64_t>> check;
+        for (auto &[key, val]: rows)
+            ++check[key].first, check[key].second += val;
+        for (std::size_t threads: {1, 3, 4}) {
+            auto counts = lmj::aggregate<std::uint64_t>(
+                    rows, [](auto &row) { return row.first; }, [](std::uint64_t &acc, auto &) { ++acc; }, threads);
+            auto sums = lmj::aggregate<std::uint64_t>(
+                    rows, [](auto &row) { return row.first; }, [](std::uint64_t &acc, auto &row) { acc += row.second; },
+                    threads, [](std::uint64_t &a, std::uint64_t b) { a += b; });
+            assert(counts.partition_count() >= threads);
+            assert(counts.size() == check.size() && sums.size() == check.size());
+            for (auto &[key, val]: check)
+                assert(counts.at(key) == val.first && sums.at(key) == val.second);
+        }
+    });
+    register_test([] {
+        constexpr int n = 1 << 17;
+        // test lmj::hash_join against a std::unordered_multimap join, including duplicate keys on both sides
+        std::vector<int> build(n), probe(n);
+        for (auto &key: build)
+            key = lmj::randint(0, n);
+        for (auto &key: probe)
+            key = lmj::randint(0, n * 2);
+        std::unordered_multimap<int, std::size_t> check;
+        for (std::size_t i = 0; i < build.size(); ++i)
+            check.emplace(build[i], i);
+        std::set<std::pair<std::size_t, std::size_t>> expected;
+        for (std::size_t i = 0; i < probe.size(); ++i)
+            for (auto [it, end] = check.equal_range(probe[i]); it != end; ++it)
+                expected.emplace(it->second, i);
+        auto identity = [](int x) { return x; };
+        for (std::size_t threads: {1, 4}) {
+            auto matches = lmj::hash_join_indices(build, probe, identity, identity, threads, 1 << 12);
+            assert(matches.size() == expected.size());
+            assert(std::set(matches.begin(), matches.end()) == expected);
+        }
+        std::atomic<std::size_t> match_count = 0;
+        lmj::hash_join(build, probe, identity, identity, [&](std::size_t b, std::size_t p) {
+            assert(build[b] == probe[p]);
+            ++match_count;
+        }, 3);
+        assert(match_count == expected.size());
+    });
+    register_test([] {
+        constexpr int n = 1 << 17;
+        // test lmj::external_hash_table spills partitions and still agrees with std::unordered_map
+        const auto directory = std::filesystem::temp_directory_path() / ("lmj_test_" + std::to_string(lmj::rand<std::uint32_t>()));
+        {
+            lmj::external_hash_table<int, std::uint64_t> table{directory, n / 16, 5};
+            std::unordered_map<int, std::uint64_t> check;
+            std::vector<lmj::external_hash_table<int, std::uint64_t>::record> batch;
+            for (int i = 0; i < n; ++i) {
+                const int key = lmj::randint(0, n);
+                batch.push_back({key, lmj::rand<std::uint64_t>()});
+                check[key] = batch.back().value;
+                if (batch.size() == 1024) {
+                    table.insert_many(batch.begin(), batch.end());
+                    batch.clear();
+                }
+            }
+            table.insert_many(batch.begin(), batch.end());
+            assert(table.in_memory_size() <= n / 16);
+            assert(table.size() >= check.size());
+
+            std::size_t total = 0;
+            table.for_each_partition([&](auto const &partition) {
+                total += partition.size();
+                for (auto &[key, value]: partition)
+                    assert(check.at(key) == value);
+            });
+            assert(total == check.size());
+
+            std::vector<int> keys(n);
+            std::iota(keys.begin(), keys.end(), 0);
+            std::vector<std::optional<std::uint64_t>> found;
+            table.find_many(keys.begin(), keys.end(), std::back_inserter(found));
+            for (int key: keys) {
+                auto it = check.find(key);
+                assert(found[key].has_value() == (it != check.end()));
+                assert(!found[key] || *found[key] == it->second);
+            }
+            for (int i = 0; i < 1024; ++i) {
+                const int key = lmj::randint(0, n);
+                assert(table.find(key) == (check.contains(key) ? std::optional{check[key]} : std::nullopt));
+            }
+            assert(table.in_memory_size() <= n / 16);
+        }
+        assert(std::filesystem::is_empty(directory));
+        std::filesystem::remove(directory);
+    });
+    register_test([] {
+        constexpr int n = 1 << 18;
+        // test lmj::hash_table erase_if and retain against std::erase_if on std::unordered_map
+        lmj::hash_table<int, int> map;
+        std::unordered_map<int, int> check;
+        for (int round = 0; round < 8; ++round) {
+            for (int i = 0; i < n / 8; ++i) {
+                const int key = lmj::rand<int>();
+                map[key] = check[key] = lmj::randint(0, 99);
+            }
+            const int threshold = lmj::randint(0, 99);
+            auto expired = [&](auto const &p) { return p.second < threshold; };
+            const auto erased = round & 1 ? map.retain([&](auto const &p) { return !expired(p); }) : lmj::erase_if(map, expired);
+            assert(erased == std::erase_if(check, expired));
+            assert(map.size() == check.size() && map.m_tomb_count == 0);
+            for (auto &[key, val]: check)
+                assert(map.at(key) == val);
+            for (auto &[key, val]: map)
+                assert(check.at(key) == val);
+        }
+        assert(map.erase_if([](auto const &) { return true; }) == check.size());
+        assert(map.empty() && map.begin() == map.end());
+        // only the probe clusters around removed elements are rehashed
+        struct counting_hash {
+            std::size_t *calls;
+
+            std::size_t operator()(int key) const {
+                ++*calls;
+                return lmj::hash<int>{}(key) * 0x9e3779b97f4a7c15ULL;
+            }
+        };
+        std::size_t calls = 0;
+        lmj::hash_table<int, int, counting_hash> counted{counting_hash{&calls}};
+        for (int i = 0; i < 100'000; ++i)
+            counted[i] = i;
+        calls = 0;
+        assert(counted.erase_if([](auto const &p) { return p.first % 100 == 0; }) == 1'000);
+        assert(calls < 10'000 && counted.size() == 99'000 && counted.m_tomb_count == 0);
+        for (int i = 0; i < 100'000; ++i)
+            assert(counted.contains(i) == (i % 100 != 0));
+    });
+    register_test([] {
+        constexpr int n = 1 << 16;
+        // test lmj::string_interner hands out dense stable ids
+        lmj::string_interner interner{256};
+        std::vector<std::string> strings;
+        for (int i = 0; i < n / 2; ++i)
+            strings.push_back(std::string(static_cast<std::size_t>(i % 300), 'x') + std::to_string(i));
+        for (int i = 0; i < n / 2; ++i) // second half repeats the first
+            strings.push_back(strings[i]);
+        std::vector<lmj::string_interner::id_type> ids;
+        interner.intern_many(strings.begin(), strings.end(), std::back_inserter(ids));
+        assert(interner.size() == n / 2);
+        for (int i = 0; i < n; ++i) {
+            assert(interner[ids[i]] == strings[i]);
+            assert(interner.intern(strings[i]) == ids[i] && interner.find(strings[i]) == ids[i]);
+            assert(ids[i] < interner.size());
+        }
+        assert(interner.find("not interned") == lmj::string_interner::npos);
+        assert(interner[interner.intern("")].empty() && interner.contains(""));
+    });
+    register_test([] {
+        constexpr int n = 1 << 18;
+        // test lmj::hyperloglog estimates in sparse and dense mode and merges
+        lmj::hyperloglog<int> small, a, b, all;
+        for (int i = 0; i < 100; ++i)
+            small.add(i), small.add(i);
+        assert(small.is_sparse() && std::abs(small.estimate() - 100) < 2);
+        std::vector<int> keys(n);
+        std::iota(keys.begin(), keys.end(), 0);
+        a.add_many(keys.begin(), keys.begin() + n / 2);
+        b.add_many(keys.begin() + n / 4, keys.end());
+        all.add_many(keys.begin(), keys.end());
+        assert(!a.is_sparse() && std::abs(a.estimate() - n / 2) < n / 2 * 0.04);
+        a.merge(b).merge(small);
+        assert(a.m_registers == all.m_registers);
+        assert(std::abs(a.estimate() - n) < n * 0.04);
+        // sparse mode never takes more memory than the dense registers
+        for (unsigned precision = 4; precision <= 18; ++precision) {
+            lmj::hyperloglog<int> sketch{precision};
+            for (int i = 0; sketch.is_sparse() && i < n; ++i) {
+                sketch.add(i);
+                assert(!sketch.is_sparse() || sketch.memory_usage() < sketch.register_count());
+            }
+            assert(!sketch.is_sparse() && sketch.memory_usage() == sketch.register_count());
+        }
+    });
+    register_test([] {
+        constexpr int n = 1 << 18;
+        // test lmj::count_min_sketch never undercounts and stays within its error bound for most keys
+        auto sketch = lmj::count_min_sketch<int>::from_error(0.001, 0.01);
+        auto other = lmj::count_min_sketch<int>::from_error(0.001, 0.01);
+        std::unordered_map<int, std::uint32_t> check;
+        std::vector<int> keys;
+        for (int i = 0; i < n; ++i) {
+            const int key = lmj::randint(0, 1 << lmj::randint(0, 16));
+            keys.push_back(key);
+            ++check[key];
+        }
+        sketch.add_many(keys.begin(), keys.begin() + n / 2);
+        for (int i = n / 2; i < n; ++i)
+            other.add(keys[i]);
+        sketch.merge(other);
+        assert(sketch.total() == n);
+        int over_bound = 0;
+        for (auto &[key, count]: check) {
+            assert(sketch.estimate(key) >= count);
+            over_bound += sketch.estimate(key) > count + 0.001 * n;
+        }
+        assert(over_bound < static_cast<int>(check.size()) / 50);
+    });
+    register_test([] {
+        constexpr int n = 1 << 16;
+        // test lmj::hash_table growth policies, reserve and shrink_to_fit, and that every element is destroyed once
+        static std::atomic<int> live = 0;
+        struct counted {
+            int value = 0;
+            counted(int v = 0) : value{v} { ++live; }
+            counted(counted const &other) : value{other.value} { ++live; }
+            ~counted() { --live; }
+            counted &operator=(counted const &) = default;
+            bool operator==(counted const &) const = default;
+        };
+        {
+            lmj::hash_table<int, counted, std::hash<int>, lmj::doubling_growth_policy<3, 4>> map;
+            std::size_t last_capacity = 0;
+            for (int i = 0; i < n; ++i) {
+                map[i] = i;
+                assert(map.capacity() == last_capacity || map.capacity() == std::max<std::size_t>(last_capacity * 2, 8));
+                last_capacity = map.capacity();
+                assert(map.size() * 4 <= map.capacity() * 3 + 4);
+            }
+            assert(live == n);
+            map.erase_if([](auto const &p) { return p.first % 64; });
+            assert(live == n / 64);
+            map.shrink_to_fit();
+            assert(map.capacity() == 2048 && map.size() == n / 64);
+            for (int i = 0; i < n; ++i)
+                assert(map.contains(i) == !(i % 64) && (i % 64 || map.at(i).value == i));
+            auto copy = map;
+            assert(copy == map && live == n / 32);
+            map.clear();
+            map.shrink_to_fit();
+            assert(map.capacity() == 0 && live == n / 64);
+        }
+        assert(live == 0);
+        lmj::hash_table<int, int> map;
+        map.reserve(n);
+        const auto capacity = map.capacity();
+        assert(capacity == 2 * n);
+        for (int i = 0; i < n; ++i)
+            map[i] = i;
+        assert(map.capacity() == capacity);
+        for (int i = 0; i < n; ++i)
+            map.erase(i);
+        map.reserve(n);
+        for (int i = 0; i < n; ++i)
+            map[i + n] = i;
+        assert(map.capacity() == capacity);
+        map.reserve(0);
+        assert(map.capacity() == capacity);
+    });
+    register_test([] {
+        constexpr std::size_t n = 1 << 18;
+        // test lmj::static_perfect_hash_table built at runtime against std::unordered_map, large enough that
+        // building it would overflow the stack if the scratch space lived there
+        using table_type = lmj::static_perfect_hash_table<int, int, n>;
+        auto pairs = std::make_unique<std::array<std::pair<int, int>, n>>();
+        std::unordered_map<int, int> check;
+        for (auto &[key, value]: *pairs) {
+            do
+                key = lmj::rand<int>();
+            while (check.contains(key));
+            value = lmj::rand<int>();
+            check[key] = value;
+        }
+        const auto table = std::make_unique<table_type>(*pairs);
+        std::set<std::size_t> indices;
+        for (auto &[key, value]: check) {
+            assert(table->at(key) == value && table->find(key)->second == value);
+            indices.insert(table->index_of(key));
+        }
+        assert(indices.size() == n);
+        for (int i = 0; i < 1 << 16; ++i) {
+            const int key = lmj::rand<int>();
+            assert(table->contains(key) == check.contains(key));
+        }
+        (*pairs)[1].first = (*pairs)[0].first;
+        bool threw = false;
+        try {
+            (void) std::make_unique<table_type>(*pairs);
+        } catch (std::invalid_argument const &) {
+            threw = true;
+        }
+        assert(threw);
+    });
+    register_test([] {
+        // test lmj::static_hash_table constructs and destroys exactly the elements it holds
+        static std::atomic<int> live = 0;
+        struct counted {
+            std::string value;
+            explicit counted(std::string v) : value{std::move(v)} { ++live; }
+            counted(counted const &other) : value{other.value} { ++live; }
+            counted(counted &&other) noexcept : value{std::move(other.value)} { ++live; }
+            ~counted() { --live; }
+            bool operator==(counted const &) const = default;
+        };
+        {
+            auto table = std::make_unique<lmj::static_hash_table<int, counted, 1024>>();
+            std::unordered_map<int, std::string> check;
+            for (int i = 0; i < 1 << 16; ++i) {
+                const int key = lmj::randint(0, 767);
+                if (lmj::randint(0, 2)) {
+                    const auto value = std::to_string(lmj::rand<int>());
+                    table->erase(key);
+                    table->emplace(key, counted{value});
+                    check[key] = value;
+                } else {
+                    table->erase(key);
+                    check.erase(key);
+                }
+                assert(live == static_cast<int>(check.size()));
+            }
+            auto copy = std::make_unique<lmj::static_hash_table<int, counted, 1024>>(*table);
+            assert(*copy == *table && live == 2 * static_cast<int>(check.size()));
+            for (auto &[key, value]: check)
+                assert(copy->at(key).value == value);
+            copy->clear();
+            assert(live == static_cast<int>(check.size()));
+        }
+        assert(live == 0);
+    });
+    register_test([] {
+        // test generation stamped clear of lmj::hash_table and lmj::static_hash_table, past epoch wraparound
+        lmj::hash_table<int, int, std::hash<int>, lmj::default_growth_policy, std::uint8_t> map;
+        auto static_map = std::make_unique<lmj::static_hash_table<int, int, 256, lmj::hash<int>, std::uint8_t>>();
+        std::unordered_map<int, int> check;
+        for (int round = 0; round < 1000; ++round) {
+            const int n = lmj::randint(0, 100);
+            for (int i = 0; i < n; ++i) {
+                const int key = lmj::randint(0, 200);
+                if (lmj::randint(0, 3)) {
+                    map[key] = (*static_map)[key] = check[key] = i;
+                } else {
+                    map.erase(key);
+                    static_map->erase(key);
+                    check.erase(key);
+                }
+            }
+            assert(map.size() == check.size() && static_map->size() == check.size());
+            for (auto &[key, val]: map)
+                assert(check.at(key) == val);
+            for (auto &[key, val]: *static_map)
+                assert(check.at(key) == val);
+            for (int key = 0; key <= 200; ++key)
+                assert(map.contains(key) == check.contains(key) && static_map->contains(key) == check.contains(key));
+            const auto capacity = map.capacity();
+            map.clear();
+            static_map->clear();
+            check.clear();
+            assert(map.empty() && map.begin() == map.end() && map.capacity() == capacity);
+            assert(static_map->empty() && static_map->begin() == static_map->end());
+        }
+    });
+    register_test([] {
+        // test lmj::shared_static_hash_table readers never observe torn values while a writer updates it,
+        // and that a bytewise copy can be attached anywhere
+        struct value_type {
+            std::uint64_t value, check;
+        };
+        using table_type = lmj::shared_static_hash_table<std::uint32_t, value_type, 128>;
+        auto memory = std::make_unique<std::uint64_t[]>(sizeof(table_type) / sizeof(std::uint64_t));
+        table_type *table = table_type::create(memory.get());
+        for (std::uint32_t key = 0; key < 64; ++key)
+            assert(table->insert_or_assign(key, {key, ~std::uint64_t{key}}));
+        std::atomic<bool> done = false;
+        auto writer = std::async(std::launch::async, [&] {
+            for (std::uint64_t i = 0; i < 1 << 18; ++i) {
+                const auto key = static_cast<std::uint32_t>(i % 64);
+                assert(!table->insert_or_assign(key, {i, ~i}));
+                if (i % 2)
+                    table->insert_or_assign(key + 64, {i, ~i});
+                else
+                    table->erase(key + 64);
+            }
+            done = true;
+        });
+        std::vector<std::future<void>> readers;
+        for (int r = 0; r < 3; ++r) {
+            readers.push_back(std::async(std::launch::async, [&] {
+                table_type const *view = table_type::attach(memory.get());
+                while (!done) {
+                    const auto key = lmj::randint<std::uint32_t>(0, 127);
+                    const auto found = view->find(key);
+                    assert(key >= 64 || found);
+                    assert(!found || found->check == ~found->value);
+                }
+            }));
+        }
+        writer.get();
+        for (auto &reader: readers)
+            reader.get();
+        auto copy = std::make_unique<std::uint64_t[]>(sizeof(table_type) / sizeof(std::uint64_t));
+        std::memcpy(copy.get(), memory.get(), sizeof(table_type));
+        table_type const *copied = table_type::attach(copy.get());
+        assert(copied->size() == table->size());
+        for (std::uint32_t key = 0; key < 128; ++key)
+            assert(copied->contains(key) == table->contains(key));
+        copy[0] = 0;
+        bool threw = false;
+        try {
+            (void) table_type::attach(copy.get());
+        } catch (std::runtime_error const &) {
+            threw = true;
+        }
+        assert(threw);
+    });
+    register_test([] {
+        constexpr std::size_t capacity = 1 << 14;
+        // test lmj::static_hopscotch_table against std::unordered_map under churn at 90% load, where some insertions fail
+        auto table = std::make_unique<lmj::static_hopscotch_table<std::uint64_t, std::string, capacity>>();
+        std::unordered_map<std::uint64_t, std::string> check;
+        std::vector<std::uint64_t> keys;
+        for (int i = 0; i < 1 << 18; ++i) {
+            if (check.size() < capacity * 9 / 10) {
+                const auto key = lmj::rand<std::uint64_t>();
+                const auto value = std::to_string(key);
+                if (table->insert(key, value)) {
+                    assert(check.emplace(key, value).second);
+                    keys.push_back(key);
+                } else { // already there, or no room left in its neighborhood
+                    assert(check.contains(key) == table->contains(key));
+                }
+            } else {
+                const auto victim = lmj::randint<std::size_t>(0, keys.size() - 1);
+                assert(table->erase(keys[victim]) && !table->erase(keys[victim]));
+                check.erase(keys[victim]);
+                keys[victim] = keys.back();
+                keys.pop_back();
+            }
+        }
+        assert(table->size() == check.size());
+        for (auto &[key, value]: check)
+            assert(table->at(key) == value);
+        std::size_t visited = 0;
+        table->for_each([&](std::uint64_t key, std::string const &value) {
+            assert(check.at(key) == value);
+            ++visited;
+        });
+        assert(visited == check.size());
+        for (int i = 0; i < 1 << 16; ++i) {
+            const auto key = lmj::rand<std::uint64_t>();
+            assert(table->contains(key) == check.contains(key));
+        }
+    });
+    register_test([] {
+        // test lmj::seqlock_static_hash_table readers never observe torn keys or values while a writer updates it
+        struct key_type {
+            std::uint64_t id, check;
+
+            bool operator==(key_type const &) const = default;
+        };
+        struct value_type {
+            std::uint64_t value, check;
+        };
+        struct key_hash {
+            std::size_t operator()(key_type const &key) const { return key.id; }
+        };
+        auto table = std::make_unique<lmj::seqlock_static_hash_table<key_type, value_type, 256, key_hash>>();
+        for (std::uint64_t id = 0; id < 64; ++id)
+            assert(table->insert_or_assign({id, ~id}, {id, ~id}));
+        std::atomic<bool> done = false;
+        auto writer = std::async(std::launch::async, [&] {
+            for (std::uint64_t i = 0; i < 1 << 18; ++i) {
+                const std::uint64_t id = i % 64;
+                assert(!table->insert_or_assign({id, ~id}, {i, ~i}));
+                if (i % 2)
+                    table->insert_or_assign({id + 64, ~(id + 64)}, {i, ~i});
+                else
+                    table->erase({id + 64, ~(id + 64)});
+            }
+            done = true;
+        });
+        std::vector<std::future<void>> readers;
+        for (int r = 0; r < 3; ++r) {
+            readers.push_back(std::async(std::launch::async, [&] {
+                while (!done) {
+                    const auto id = lmj::randint<std::uint64_t>(0, 127);
+                    const auto found = table->find({id, ~id});
+                    assert(id >= 64 || found);
+                    assert(!found || found->check == ~found->value);
+                    assert(!table->contains({id, id}));
+                }
+            }));
+        }
+        writer.get();
+        for (auto &reader: readers)
+            reader.get();
+        assert(table->size() == 96);
+        std::size_t count = 0;
+        for (auto const &[key, value]: table->table()) {
+            assert(key.check == ~key.id && value.check == ~value.value);
+            ++count;
+        }
+        assert(count == table->size());
+        table->clear();
+        assert(table->empty() && !table->contains({0, ~std::uint64_t{0}}));
+    });
+    register_test([] {
+        constexpr std::size_t n = 1000;
+        // test lmj::static_flat_table built at runtime against std::map, including range queries
+        std::array<std::pair<int, int>, n> pairs{};
+        std::map<int, int> check;
+        for (auto &[key, value]: pairs) {
+            do
+                key = lmj::randint(-100000, 100000);
+            while (check.contains(key));
+            value = lmj::rand<int>();
+            check[key] = value;
+        }
+        const auto table = lmj::make_static_flat_table(pairs);
+        assert(std::equal(table.begin(), table.end(), check.begin(), check.end(),
+                          [](auto const &a, auto const &b) { return a.first == b.first && a.second == b.second; }));
+        for (int i = 0; i < 1 << 14; ++i) {
+            const int key = lmj::randint(-100001, 100001);
+            assert(table.contains(key) == check.contains(key));
+            const auto lower = table.lower_bound(key);
+            const auto check_lower = check.lower_bound(key);
+            assert((lower == table.end()) == (check_lower == check.end()));
+            assert(lower == table.end() || lower.key() == check_lower->first);
+            const auto upper = table.upper_bound(key);
+            assert(upper == table.end() || upper.key() == check.upper_bound(key)->first);
+            const int last = key + lmj::randint(0, 2000);
+            const auto range = table.range(key, last);
+            assert(std::ranges::distance(range) == std::distance(check_lower, check.lower_bound(last)));
+        }
+        pairs[1].first = pairs[0].first;
+        bool threw = false;
+        try {
+            (void) lmj::make_static_flat_table(pairs);
+        } catch (std::invalid_argument const &) {
+            threw = true;
+        }
+        assert(threw);
+    });
+    register_test([] {
+        // test lmj::static_vector constructs and destroys exactly the elements it holds, against std::vector
+        static std::atomic<int> live = 0;
+        struct counted {
+            std::string value;
+            explicit counted(std::string v) : value{std::move(v)} { ++live; }
+            counted(counted const &other) : value{other.value} { ++live; }
+            counted(counted &&other) noexcept : value{std::move(other.value)} { ++live; }
+            counted &operator=(counted const &) = default;
+            counted &operator=(counted &&) noexcept = default;
+            ~counted() { --live; }
+            bool operator==(counted const &) const = default;
+        };
+        {
+            lmj::static_vector<counted, 64> v;
+            assert(live == 0);
+            std::vector<std::string> check;
+            for (int i = 0; i < 1 << 14; ++i) {
+                if (check.size() < 64 && lmj::randint(0, 2)) {
+                    check.push_back(std::to_string(i));
+                    v.emplace_back(check.back());
+                } else if (!check.empty()) {
+                    const auto first = lmj::randint<std::size_t>(0, check.size() - 1);
+                    const auto last = lmj::randint<std::size_t>(first, std::min(check.size(), first + 3));
+                    v.erase(v.begin() + first, v.begin() + last);
+                    check.erase(check.begin() + static_cast<std::ptrdiff_t>(first),
+                                check.begin() + static_cast<std::ptrdiff_t>(last));
+                }
+                assert(live == static_cast<int>(check.size()) && v.size() == check.size());
+            }
+            for (std::size_t i = 0; i < check.size(); ++i)
+                assert(v[i].value == check[i]);
+            auto copy = v;
+            assert(copy == v && live == 2 * static_cast<int>(check.size()));
+            copy.clear();
+            assert(live == static_cast<int>(check.size()));
+        }
+        assert(live == 0);
+        lmj::static_vector<std::uint64_t, 256> ints(100, std::uint64_t{7});
+        ints.erase(ints.begin() + 10, ints.begin() + 90);
+        auto ints_copy = ints;
+        assert(ints_copy.size() == 20 && std::count(ints_copy.begin(), ints_copy.end(), 7) == 20);
+    });
+    register_test([] {
+        // test lmj::small_vector against std::vector while it overflows to the heap and shrinks back inline
+        lmj::small_vector<std::string, 4> v;
+        std::vector<std::string> check;
+        for (int round = 0; round < 1 << 10; ++round) {
+            const auto target = lmj::randint(0, 1) ? lmj::randint<std::size_t>(0, 4) : lmj::randint<std::size_t>(0, 300);
+            while (check.size() < target) {
+                check.push_back(std::to_string(lmj::rand<int>()));
+                v.push_back(check.back());
+            }
+            while (check.size() > target) {
+                assert(v.pop_back() == check.back());
+                check.pop_back();
+            }
+            if (!check.empty()) {
+                const auto first = lmj::randint<std::size_t>(0, check.size() - 1);
+                v.erase(v.begin() + first);
+                check.erase(check.begin() + static_cast<std::ptrdiff_t>(first));
+            }
+            assert(v.to_std_vector() == check);
+            assert(v.is_inline() == (v.capacity() == 4));
+            if (lmj::randint(0, 3) == 0) {
+                v.shrink_to_fit();
+                assert(v.is_inline() == (check.size() <= 4) && v.to_std_vector() == check);
+            }
+            auto copy = v;
+            auto moved = std::move(copy);
+            assert(moved == v && copy.empty());
+        }
+        lmj::small_vector<std::uint64_t, 8> ints(1000, std::uint64_t{7});
+        assert(!ints.is_inline() && std::count(ints.begin(), ints.end(), 7) == 1000);
+    });
+    register_test([] {
+        // test the bulk mutations of lmj::static_vector and lmj::small_vector against std::vector
+        // for trivial and non trivial elements
+        auto run = [](auto make, auto v) {
+            using value_type = decltype(make(0));
+            std::vector<value_type> check;
+            for (int i = 0; i < 1 << 12; ++i) {
+                std::vector<value_type> source(lmj::randint<std::size_t>(0, 8));
+                for (auto &value: source)
+                    value = make(lmj::rand<int>());
+                const auto pos = lmj::randint<std::size_t>(0, check.size());
+                const auto cpos = static_cast<std::ptrdiff_t>(pos);
+                switch (check.size() + source.size() > 256 ? 4 : lmj::randint(0, 5)) {
+                    case 0: {
+                        const auto inserted = v.insert(v.begin() + cpos, source.begin(), source.end());
+                        assert(inserted == v.begin() + cpos);
+                        check.insert(check.begin() + cpos, source.begin(), source.end());
+                        break;
+                    }
+                    case 1: {
+                        std::list<value_type> list{source.begin(), source.end()};
+                        v.insert(v.begin() + cpos, list.begin(), list.end());
+                        check.insert(check.begin() + cpos, source.begin(), source.end());
+                        break;
+                    }
+                    case 2:
+                        v.append_range(source);
+                        check.insert(check.end(), source.begin(), source.end());
+                        break;
+                    case 3:
+                        v.emplace(v.begin() + cpos, make(i));
+                        check.insert(check.begin() + cpos, make(i));
+                        break;
+                    case 4: {
+                        const auto n = lmj::randint<std::size_t>(0, std::min<std::size_t>(256, check.size() + 8));
+                        v.resize(n);
+                        check.resize(n);
+                        break;
+                    }
+                    default:
+                        if (lmj::randint(0, 8) == 0) {
+                            v.assign(source.begin(), source.end());
+                            check.assign(source.begin(), source.end());
+                        } else if (!check.empty()) {
+                            const auto last = lmj::randint<std::size_t>(pos, check.size());
+                            v.erase(v.begin() + cpos, v.begin() + static_cast<std::ptrdiff_t>(last));
+                            check.erase(check.begin() + cpos, check.begin() + static_cast<std::ptrdiff_t>(last));
+                        }
+                }
+                assert(v.to_std_vector() == check);
+            }
+        };
+        run([](int x) { return x; }, lmj::static_vector<int, 256>{});
+        run([](int x) { return std::to_string(x); }, lmj::static_vector<std::string, 256>{});
+        run([](int x) { return x; }, lmj::small_vector<int, 16>{});
+        run([](int x) { return std::to_string(x); }, lmj::small_vector<std::string, 16>{});
+    });
+    register_test([] {
+        // test lmj::static_string find against std::string_view and as a key of lmj::hash_table
+        for (int i = 0; i < 1 << 14; ++i) {
+            std::string check;
+            const auto length = lmj::randint<std::size_t>(0, 40);
+            for (std::size_t j = 0; j < length; ++j)
+                check += static_cast<char>(lmj::randint('a', 'd'));
+            const lmj::static_string<40> s = check;
+            const auto pos = lmj::randint<std::size_t>(0, 42);
+            const char c = static_cast<char>(lmj::randint('a', 'e'));
+            assert(s.find(c, pos) == std::string_view{check}.find(c, pos));
+            const std::string needle = check.substr(lmj::randint<std::size_t>(0, length), lmj::randint(0, 3)) + "a";
+            assert(s.find(needle, pos) == std::string_view{check}.find(needle, pos));
+            assert(s == check && s.str() == check && (s < "b") == (check < "b"));
+        }
+        lmj::hash_table<lmj::static_string<16>, int> table;
+        std::unordered_map<std::string, int> check;
+        for (int i = 0; i < 1 << 12; ++i) {
+            const auto symbol = std::to_string(lmj::randint(0, 999));
+            table[symbol] += i;
+            check[symbol] += i;
+        }
+        assert(table.size() == check.size());
+        for (auto &[symbol, sum]: check)
+            assert(table.at(symbol) == sum);
+    });
+    register_test([] {
+        // test lmj::flat_map and lmj::flat_set against std::map, including one pass sorted merges
+        lmj::flat_map<int, int, 256> map;
+        lmj::flat_set<int, 256> set;
+        std::map<int, int> check;
+        for (int i = 0; i < 1 << 14; ++i) {
+            const int key = lmj::randint(0, 299);
+            switch (check.size() > 240 ? 2 : lmj::randint(0, 3)) {
+                case 0:
+                    assert(map.insert_or_assign(key, i) == !check.contains(key));
+                    assert(set.insert(key) == !check.contains(key));
+                    check[key] = i;
+                    break;
+                case 1: {
+                    std::map<int, int> batch;
+                    for (int j = lmj::randint(0, 8); j > 0; --j)
+                        batch[lmj::randint(0, 299)] = i + j;
+                    std::vector<std::pair<int, int>> pairs{batch.begin(), batch.end()};
+                    std::vector<int> keys;
+                    for (auto &[batch_key, value]: batch) {
+                        keys.push_back(batch_key);
+                        check[batch_key] = value;
+                    }
+                    map.insert_sorted(pairs.begin(), pairs.end());
+                    set.insert_sorted(keys.begin(), keys.end());
+                    break;
+                }
+                default:
+                    assert(map.erase(key) == check.contains(key));
+                    assert(set.erase(key) == check.erase(key));
+            }
+            assert(map.size() == check.size() && set.size() == check.size());
+            const int probe = lmj::randint(-1, 300);
+            assert(map.contains(probe) == check.contains(probe) && set.contains(probe) == check.contains(probe));
+            assert(static_cast<std::size_t>(std::distance(check.begin(), check.lower_bound(probe))) == map.lower_bound(probe));
+        }
+        std::size_t position = 0;
+        for (auto &[key, value]: check) {
+            assert(map.keys()[position] == key && map.values()[position] == value && set.begin()[position] == key);
+            ++position;
+        }
+    });
+    register_test([] {
+        // test lmj::spsc_queue delivers everything in order across threads, one at a time and in batches
+        auto run = [](auto make, std::size_t count) {
+            using value_type = decltype(make(0));
+            auto queue = std::make_unique<lmj::spsc_queue<value_type, 64>>();
+            auto producer = std::async(std::launch::async, [&] {
+                std::vector<value_type> batch;
+                for (std::size_t i = 0; i < count;) {
+                    if (lmj::randint(0, 1)) {
+                        if (queue->try_push(make(i)))
+                            ++i;
+                        else
+                            std::this_thread::yield();
+                        continue;
+                    }
+                    batch.clear();
+                    for (std::size_t j = i; j < std::min(count, i + lmj::randint<std::size_t>(1, 100)); ++j)
+                        batch.push_back(make(j));
+                    const std::size_t pushed = queue->push_n(batch.begin(), batch.size());
+                    if (!pushed)
+                        std::this_thread::yield();
+                    i += pushed;
+                }
+            });
+            std::vector<value_type> batch(100);
+            for (std::size_t i = 0; i < count;) {
+                if (lmj::randint(0, 1)) {
+                    if (auto value = queue->try_pop()) {
+                        assert(*value == make(i));
+                        ++i;
+                    } else {
+                        std::this_thread::yield();
+                    }
+                    continue;
+                }
+                const std::size_t popped = queue->pop_n(batch.begin(), lmj::randint<std::size_t>(1, 100));
+                if (!popped)
+                    std::this_thread::yield();
+                for (std::size_t j = 0; j < popped; ++j, ++i)
+                    assert(batch[j] == make(i));
+            }
+            producer.get();
+            assert(queue->empty() && !queue->try_pop());
+        };
+        run([](std::size_t i) { return i; }, 1 << 20);
+        run([](std::size_t i) { return std::to_string(i); }, 1 << 16);
+    });
+    register_test([] {
+        // test lmj::mpmc_queue delivers every element exactly once with several producers and consumers,
+        // mixing the non blocking and the blocking calls
+        auto run = [](auto &queue) {
+            constexpr std::uint64_t producers = 4, consumers = 3, per_producer = 1 << 15;
+            std::atomic<std::uint64_t> sum = 0, received = 0;
+            std::vector<std::future<void>> threads;
+            for (std::uint64_t p = 0; p < producers; ++p) {
+                threads.push_back(std::async(std::launch::async, [&, p] {
+                    for (std::uint64_t i = 0; i < per_producer; ++i) {
+                        const auto value = std::to_string(p * per_producer + i);
+                        if (i % 2)
+                            queue.push(value);
+                        else
+                            while (!queue.try_push(value))
+                                std::this_thread::yield();
+                    }
+                }));
+            }
+            for (std::uint64_t c = 0; c < consumers; ++c) {
+                threads.push_back(std::async(std::launch::async, [&, c] {
+                    for (std::uint64_t i = 0; received < producers * per_producer; ++i) {
+                        std::optional<std::string> value;
+                        // only the first consumer blocks, and only while elements are guaranteed to remain
+                        if (c == 0 && i % 2 && received + consumers < producers * per_producer / 2)
+                            value = queue.pop();
+                        else
+                            value = queue.try_pop();
+                        if (!value) {
+                            std::this_thread::yield();
+                            continue;
+                        }
+                        sum += std::stoull(*value);
+                        ++received;
+                    }
+                }));
+            }
+            for (auto &thread: threads)
+                thread.get();
+            const std::uint64_t n = producers * per_producer;
+            assert(received == n && sum == n * (n - 1) / 2 && queue.empty());
+        };
+        auto fixed = std::make_unique<lmj::mpmc_queue<std::string, 64>>();
+        run(*fixed);
+        lmj::mpmc_queue<std::string> dynamic{100};
+        assert(dynamic.capacity() == 128);
+        run(dynamic);
+    });
+    register_test([] {
+        // test lmj::bitvector and lmj::rank_select against a std::vector<bool> at several densities,
+        // with sizes that end mid word and mid block
+        for (const int percent: {0, 1, 50, 99, 100}) {
+            for (const std::size_t n: {std::size_t{1}, std::size_t{2048}, std::size_t{100'003}}) {
+                std::vector<bool> expected(n);
+                lmj::bitvector bits;
+                for (std::size_t i = 0; i < n; ++i) {
+                    expected[i] = lmj::randint(0, 99) < percent;
+                    bits.push_back(expected[i]);
+                }
+                const lmj::rank_select index{bits};
+                assert(index.overhead_bytes() * 8 <= n / 25 + 256);
+                std::size_t ones = 0, next = bits.find_first();
+                for (std::size_t i = 0; i < n; ++i) {
+                    assert(bits[i] == expected[i] && index.rank1(i) == ones);
+                    if (expected[i]) {
+                        assert(next == i && index.select1(ones) == i);
+                        next = bits.find_next(i);
+                        ++ones;
+                    }
+                }
+                assert(next == n && index.rank1(n) == ones && bits.count() == ones && index.ones() == ones);
+                std::size_t visited = 0;
+                bits.for_each_set([&](std::size_t i) {
+                    assert(expected[i]);
+                    ++visited;
+                });
+                assert(visited == ones && (~bits).count() == n - ones);
+            }
+        }
+    });
+    register_test([] {
+        // test lmj::inplace_function as the task type of an lmj::mpmc_queue drained by worker threads,
+        // with move only captures and every capture destroyed exactly once
+        using task = lmj::inplace_function<void(std::atomic<std::uint64_t> &)>;
+        constexpr std::uint64_t workers = 4, tasks = 1 << 14;
+        auto tracker = std::make_shared<int>();
+        {
+            lmj::mpmc_queue<task> queue{256};
+            std::atomic<std::uint64_t> sum = 0;
+            std::vector<std::future<void>> threads;
+            for (std::uint64_t w = 0; w < workers; ++w)
+                threads.push_back(std::async(std::launch::async, [&] {
+                    for (task job = queue.pop(); job; job = queue.pop())
+                        job(sum);
+                }));
+            for (std::uint64_t i = 0; i < tasks; ++i) {
+                auto value = std::make_unique<std::uint64_t>(i);
+                queue.push([value = std::move(value), tracker](std::atomic<std::uint64_t> &out) { out += *value; });
+            }
+            for (std::uint64_t w = 0; w < workers; ++w)
+                queue.push(nullptr);
+            for (auto &thread: threads)
+                thread.get();
+            assert(sum == tasks * (tasks - 1) / 2);
+        }
+        assert(tracker.use_count() == 1);
+        lmj::inplace_function<int(int), 16> f = [offset = 3](int x) { return x + offset; };
+        lmj::inplace_function<int(int), 16> g = std::move(f);
+        assert(!f && g && g(4) == 7 && g.capacity() == 16);
+        g = nullptr;
+        assert(g == nullptr);
+    });
     for (auto &&i: test_futures)
         i.get();
     lmj::print("All tests passed!");
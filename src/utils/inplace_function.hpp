@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace lmj {
+template<class signature, std::size_t _capacity = 56, std::size_t _alignment = alignof(std::max_align_t)>
+class inplace_function;
+
+/**
+ * type erased callable like std::function that stores the callable in _capacity inline bytes and never allocates,
+ * a callable that doesn't fit fails to compile instead of going to the heap
+ * @note move only, so it also holds move only callables (e.g. lambdas capturing a std::unique_ptr), which makes it
+ * a task type for queues and thread pools
+ * @note the defaults make it exactly one cache line
+ */
+template<class R, class... Args, std::size_t _capacity, std::size_t _alignment>
+class inplace_function<R(Args...), _capacity, _alignment> {
+    struct vtable {
+        R (*invoke)(void *, Args &&...);
+        void (*relocate)(void *, void *); // move constructs into the first storage and destroys the second
+        void (*destroy)(void *);
+    };
+
+    template<class F>
+    static constexpr vtable vtable_for = {
+            [](void *f, Args &&...args) -> R {
+                if constexpr (std::is_void_v<R>)
+                    std::invoke(*std::launder(static_cast<F *>(f)), std::forward<Args>(args)...);
+                else
+                    return std::invoke(*std::launder(static_cast<F *>(f)), std::forward<Args>(args)...);
+            },
+            [](void *dst, void *src) {
+                F *from = std::launder(static_cast<F *>(src));
+                std::construct_at(static_cast<F *>(dst), std::move(*from));
+                std::destroy_at(from);
+            },
+            [](void *f) { std::destroy_at(std::launder(static_cast<F *>(f))); }};
+
+public:
+    using result_type = R;
+
+    alignas(_alignment) mutable std::byte m_storage[_capacity];
+    vtable const *m_vtable = nullptr; // nullptr while empty
+
+    inplace_function() = default;
+
+    inplace_function(std::nullptr_t) {}
+
+    template<class G, class F = std::decay_t<G>>
+        requires(!std::is_same_v<F, inplace_function> && std::is_invocable_r_v<R, F &, Args...>)
+    inplace_function(G &&callable) {
+        static_assert(sizeof(F) <= _capacity, "callable too large for inplace_function, raise its capacity");
+        static_assert(_alignment % alignof(F) == 0, "callable too aligned for inplace_function, raise its alignment");
+        static_assert(std::is_nothrow_move_constructible_v<F>, "inplace_function moves its callable around");
+        std::construct_at(reinterpret_cast<F *>(m_storage), std::forward<G>(callable));
+        m_vtable = &vtable_for<F>;
+    }
+
+    inplace_function(inplace_function &&other) noexcept {
+        _steal(other);
+    }
+
+    inplace_function &operator=(inplace_function &&other) noexcept {
+        if (this != &other) {
+            reset();
+            _steal(other);
+        }
+        return *this;
+    }
+
+    inplace_function &operator=(std::nullptr_t) {
+        reset();
+        return *this;
+    }
+
+    inplace_function(inplace_function const &) = delete;
+
+    inplace_function &operator=(inplace_function const &) = delete;
+
+    ~inplace_function() {
+        reset();
+    }
+
+    /**
+     * @brief calls the stored callable, which must exist
+     */
+    R operator()(Args... args) const {
+        assert(m_vtable && "calling an empty inplace_function");
+        return m_vtable->invoke(m_storage, std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief destroys the stored callable
+     */
+    void reset() {
+        if (m_vtable)
+            m_vtable->destroy(m_storage);
+        m_vtable = nullptr;
+    }
+
+    explicit operator bool() const {
+        return m_vtable != nullptr;
+    }
+
+    [[nodiscard]] bool operator==(std::nullptr_t) const {
+        return m_vtable == nullptr;
+    }
+
+    [[nodiscard]] static constexpr std::size_t capacity() { return _capacity; }
+
+private:
+    /**
+     * @brief moves the callable of other into this, which must be empty, leaving other empty
+     */
+    void _steal(inplace_function &other) {
+        if (other.m_vtable)
+            other.m_vtable->relocate(m_storage, other.m_storage);
+        m_vtable = std::exchange(other.m_vtable, nullptr);
+    }
+};
+
+// tests
+static_assert(sizeof(inplace_function<void()>) == 64);
+static_assert(!std::is_copy_constructible_v<inplace_function<void()>>);
+static_assert(std::is_nothrow_move_constructible_v<inplace_function<int(int)>>);
+static_assert(std::is_constructible_v<inplace_function<long(int)>, int (*)(int)>);
+static_assert(!std::is_constructible_v<inplace_function<void(int)>, void (*)(char const *)>);
+} // namespace lmj
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+
+namespace lmj {
+namespace detail {
+template<class T>
+constexpr bool word_copyable_v = sizeof(T) % sizeof(std::uint64_t) == 0 && alignof(T) >= alignof(std::uint64_t);
+
+/**
+ * @brief copies a T from src with relaxed atomic loads, word by word if T allows, so racing with
+ * seqlock_store isn't a data race
+ * @note the result may be torn, it's only meaningful once the surrounding seqlock read validated
+ */
+template<class T>
+T seqlock_load(void const *src) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    if constexpr (word_copyable_v<T>) {
+        std::array<std::uint64_t, sizeof(T) / sizeof(std::uint64_t)> words;
+        auto *p = static_cast<std::uint64_t *>(const_cast<void *>(src));
+        for (std::size_t i = 0; i < words.size(); ++i)
+            words[i] = std::atomic_ref<std::uint64_t>{p[i]}.load(std::memory_order_relaxed);
+        return std::bit_cast<T>(words);
+    } else {
+        std::array<unsigned char, sizeof(T)> bytes;
+        auto *p = static_cast<unsigned char *>(const_cast<void *>(src));
+        for (std::size_t i = 0; i < bytes.size(); ++i)
+            bytes[i] = std::atomic_ref<unsigned char>{p[i]}.load(std::memory_order_relaxed);
+        return std::bit_cast<T>(bytes);
+    }
+}
+
+/**
+ * @brief writes value to dst with relaxed atomic stores, the counterpart of seqlock_load
+ */
+template<class T>
+void seqlock_store(void *dst, T const &value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    if constexpr (word_copyable_v<T>) {
+        const auto words = std::bit_cast<std::array<std::uint64_t, sizeof(T) / sizeof(std::uint64_t)>>(value);
+        auto *p = static_cast<std::uint64_t *>(dst);
+        for (std::size_t i = 0; i < words.size(); ++i)
+            std::atomic_ref<std::uint64_t>{p[i]}.store(words[i], std::memory_order_relaxed);
+    } else {
+        const auto bytes = std::bit_cast<std::array<unsigned char, sizeof(T)>>(value);
+        auto *p = static_cast<unsigned char *>(dst);
+        for (std::size_t i = 0; i < bytes.size(); ++i)
+            std::atomic_ref<unsigned char>{p[i]}.store(bytes[i], std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief linear probe for key that seqlock readers can run while a writer changes the table, it stops at the first
+ * empty slot and after capacity slots, so it ends even if a racing write left the table inconsistent
+ * @param load_state(idx) control word of slot idx, read with a relaxed atomic load
+ * @param load_key(idx) copy of the key in slot idx, read with seqlock_load
+ * @return index of the active slot holding key or capacity
+ */
+template<class key_tp, class word_type, class LoadState, class LoadKey>
+std::size_t seqlock_find_index(key_tp const &key, std::size_t home, std::size_t capacity, word_type inactive,
+                               word_type active, LoadState &&load_state, LoadKey &&load_key) {
+    std::size_t idx = home;
+    for (std::size_t i = 0; i < capacity; ++i, idx = idx + 1 < capacity ? idx + 1 : 0) {
+        const word_type state = load_state(idx);
+        if (state == inactive)
+            break;
+        if (state == active && load_key(idx) == key)
+            return idx;
+    }
+    return capacity;
+}
+} // namespace detail
+
+/**
+ * sequence lock for a single writer and any number of optimistic readers, the sequence is odd while a write
+ * is in progress and readers retry if it changed while they read
+ * @note a plain trivially copyable word accessed through std::atomic_ref, so it also works inside
+ * memory shared between processes
+ */
+class seqlock {
+    static_assert(std::atomic_ref<std::uint64_t>::is_always_lock_free);
+
+public:
+    alignas(std::atomic_ref<std::uint64_t>::required_alignment) std::uint64_t m_sequence = 0;
+
+    /**
+     * @return sequence to pass to read_retry, waits while a write is in progress
+     */
+    [[nodiscard]] std::uint64_t read_begin() const {
+        std::uint64_t sequence;
+        while ((sequence = _ref().load(std::memory_order_acquire)) & 1)
+            std::this_thread::yield();
+        return sequence;
+    }
+
+    /**
+     * @return whether a write happened since read_begin returned sequence, then everything read is invalid
+     */
+    [[nodiscard]] bool read_retry(std::uint64_t sequence) const {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return _ref().load(std::memory_order_relaxed) != sequence;
+    }
+
+    void write_lock() {
+        _ref().store(_ref().load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void write_unlock() {
+        _ref().store(_ref().load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief calls f until it ran without a concurrent write
+     * @return result of the last call of f
+     */
+    template<class F>
+    auto read(F &&f) const {
+        for (;;) {
+            const std::uint64_t sequence = read_begin();
+            auto result = f();
+            if (!read_retry(sequence))
+                return result;
+        }
+    }
+
+    /**
+     * @brief calls f while holding the write side, there must never be more than one writer at a time
+     */
+    template<class F>
+    decltype(auto) write(F &&f) {
+        struct unlocker {
+            seqlock &lock;
+
+            ~unlocker() { lock.write_unlock(); }
+        };
+        write_lock();
+        unlocker guard{*this};
+        return f();
+    }
+
+private:
+    [[nodiscard]] std::atomic_ref<std::uint64_t> _ref() const {
+        return std::atomic_ref<std::uint64_t>{const_cast<std::uint64_t &>(m_sequence)};
+    }
+};
+} // namespace lmj
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "concepts.hpp"
+#include "inplace_function.hpp"
 #include "misc_utils.hpp"
+#include "seqlock.hpp"
 #include "simple_structs.hpp"
 #include "timer.hpp"
\ No newline at end of file